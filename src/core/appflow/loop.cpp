@@ -1,6 +1,7 @@
 #include "loop.hpp"
 
 #include "../ecs/core.hpp"
+#include "../job_system.hpp"
 #include "../log.hpp"
 #include "../os/window.hpp"
 #include "../vkcore/core.hpp"
@@ -31,6 +32,8 @@ void Loop::run() {
         if (!window.process())
             break;
         ecs.update();
+        JobSystem::Get().runMainThreadJobs();
+        JobSystem::Get().profileStats();
         renderer.render();
         framerate_adjuster.wait();
     }
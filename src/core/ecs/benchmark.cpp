@@ -135,10 +135,13 @@ int main() {
         int count = entityCount * 0.4;
         std::vector<ComponentId> ids = {ComponentIdByType<TransformComponent>::value};
         std::vector<void*> ptrs(1);
-        ecs.allocateEntity(std::span(ids), std::span(ptrs), count);
-        
-        TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
-        for(int i=0; i<count; ++i) transforms[i].pos = glm::vec3(i, 0, 0);
+        for (int base = 0; base < count;) {
+            const int n = ecs.allocateEntity(std::span(ids), std::span(ptrs), count - base).count;
+
+            TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
+            for(int i=0; i<n; ++i) transforms[i].pos = glm::vec3(base + i, 0, 0);
+            base += n;
+        }
     }
 
     // Archetype 2: Dynamic (Transform + Velocity) - 40%
@@ -149,13 +152,16 @@ int main() {
             ComponentIdByType<VelocityComponent>::value
         };
         std::vector<void*> ptrs(2);
-        ecs.allocateEntity(std::span(ids), std::span(ptrs), count);
-        
-        TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
-        VelocityComponent* velocities = static_cast<VelocityComponent*>(ptrs[1]);
-        for(int i=0; i<count; ++i) {
-            transforms[i].pos = glm::vec3(i, 10, 0);
-            velocities[i].velocity = glm::vec3(1.0f, 0.0f, 0.0f);
+        for (int base = 0; base < count;) {
+            const int n = ecs.allocateEntity(std::span(ids), std::span(ptrs), count - base).count;
+
+            TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
+            VelocityComponent* velocities = static_cast<VelocityComponent*>(ptrs[1]);
+            for(int i=0; i<n; ++i) {
+                transforms[i].pos = glm::vec3(base + i, 10, 0);
+                velocities[i].velocity = glm::vec3(1.0f, 0.0f, 0.0f);
+            }
+            base += n;
         }
     }
 
@@ -168,15 +174,18 @@ int main() {
             ComponentIdByType<RenderComponent>::value
         };
         std::vector<void*> ptrs(3);
-        ecs.allocateEntity(std::span(ids), std::span(ptrs), count);
-        
-        TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
-        VelocityComponent* velocities = static_cast<VelocityComponent*>(ptrs[1]);
-        RenderComponent* renders = static_cast<RenderComponent*>(ptrs[2]);
-        for(int i=0; i<count; ++i) {
-            transforms[i].pos = glm::vec3(i, 20, 0);
-            velocities[i].velocity = glm::vec3(0.0f, 1.0f, 0.0f);
-            renders[i].mesh_id = i % 10;
+        for (int base = 0; base < count;) {
+            const int n = ecs.allocateEntity(std::span(ids), std::span(ptrs), count - base).count;
+
+            TransformComponent* transforms = static_cast<TransformComponent*>(ptrs[0]);
+            VelocityComponent* velocities = static_cast<VelocityComponent*>(ptrs[1]);
+            RenderComponent* renders = static_cast<RenderComponent*>(ptrs[2]);
+            for(int i=0; i<n; ++i) {
+                transforms[i].pos = glm::vec3(base + i, 20, 0);
+                velocities[i].velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+                renders[i].mesh_id = (base + i) % 10;
+            }
+            base += n;
         }
     }
 
@@ -11,24 +11,37 @@ void ComponentInfoManager::registerComponent(ComponentInfo info) {
     name_id_map.insert({info.name, info.id});
 }
 
+bool ComponentInfoManager::isRegistered(ComponentId id) const { return id < infos.size() && !infos[id].name.empty(); }
 size_t ComponentInfoManager::getIndexFromComponentId(ComponentId id) const { return static_cast<size_t>(id); }
 size_t ComponentInfoManager::getSizeFromIndex(size_t index) const { return infos[index].size; }
+ComponentStorage ComponentInfoManager::getStorageFromIndex(size_t index) const { return infos[index].storage; }
+bool ComponentInfoManager::isRelocatableFromIndex(size_t index) const { return infos[index].relocatable; }
 ComponentId ComponentInfoManager::getComponentIdByName(const std::string &name) const { return name_id_map.at(name); }
 
 void ComponentInfoManager::loadByJson(void *dst_ptr, const nlohmann::json &hint) const {
     const auto id = getComponentIdByName(hint.at("name"));
+    if (infos[id].storage == ComponentStorage::Tag)
+        return;
 
     if (infos[id].cb_load_by_json2) {
         JsonArchiveLoader ar{static_cast<const void *>(&hint)};
         infos[id].cb_load_by_json2(dst_ptr, ar);
     }
+}
 
-    initComponent(id, dst_ptr);
+void ComponentInfoManager::initComponents(ComponentId id, void *first, size_t count) const {
+    // tags have no data, shared values are plain data owned by the chunk
+    if (infos[id].storage == ComponentStorage::Tag || infos[id].storage == ComponentStorage::Shared)
+        return;
+    if (infos[id].cb_init_range)
+        infos[id].cb_init_range(first, count);
 }
 
-void ComponentInfoManager::initComponent(ComponentId id, void *ptr) const {
-    if (infos[id].cb_init)
-        infos[id].cb_init(ptr);
+void ComponentInfoManager::deinitComponents(ComponentId id, void *first, size_t count) const {
+    if (infos[id].storage == ComponentStorage::Tag || infos[id].storage == ComponentStorage::Shared)
+        return;
+    if (infos[id].cb_deinit_range)
+        infos[id].cb_deinit_range(first, count);
 }
 
 } // namespace Pelican
\ No newline at end of file
@@ -17,8 +17,12 @@ struct ComponentInfo {
     ComponentId id;
     uint32_t size;
     std::string name;
-    void (*cb_init)(void *ptr) = nullptr;
-    void (*cb_deinit)(void *ptr) = nullptr;
+    ComponentStorage storage = ComponentStorage::Column;
+    // rows can be moved with memcpy (trivially copyable); sorting and world images need it
+    bool relocatable = true;
+    // called for `count` consecutive objects; nullptr when the component has no init()/deinit()
+    void (*cb_init_range)(void *first, size_t count) = nullptr;
+    void (*cb_deinit_range)(void *first, size_t count) = nullptr;
 
     void (*cb_load_by_json2)(void *ptr, JsonArchiveLoader &json) = nullptr;
 };
@@ -32,11 +36,16 @@ DECLARE_MODULE(ComponentInfoManager) {
 
     void registerComponent(ComponentInfo info);
 
+    bool isRegistered(ComponentId id) const;
     size_t getIndexFromComponentId(ComponentId id) const;
     size_t getSizeFromIndex(size_t index) const;
+    ComponentStorage getStorageFromIndex(size_t index) const;
+    bool isRelocatableFromIndex(size_t index) const;
     ComponentId getComponentIdByName(const std::string &name) const;
+    // loads the serialized fields only; call initComponents() afterwards
     void loadByJson(void *ptr, const nlohmann::json &json) const;
-    void initComponent(ComponentId id, void *ptr) const;
+    void initComponents(ComponentId id, void *first, size_t count) const;
+    void deinitComponents(ComponentId id, void *first, size_t count) const;
 };
 
 } // namespace Pelican
\ No newline at end of file
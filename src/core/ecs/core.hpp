@@ -15,9 +15,9 @@ DECLARE_MODULE(ECSCore) {
   public:
     ECSCoreTemplatePublic &getTemplatePublicModule() { return sub; }
 
-    EntityId allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs,
-                            size_t count) {
-        return sub.allocateEntity(component_ids, component_ptrs, count);
+    EntityBatch allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs,
+                            size_t count, std::span<const void *const> shared_values = {}) {
+        return sub.allocateEntity(component_ids, component_ptrs, count, shared_values);
     }
     void remove(EntityId id) { sub.remove(id); }
     void compaction() { sub.compaction(); }
@@ -32,6 +32,32 @@ DECLARE_MODULE(ECSCore) {
         return sub.registerSystem<TSystem, TComponents...>(system, std::move(depends_list), true);
     }
     void unregisterSystem(SystemId system_id) { sub.unregisterSystem(system_id); }
+    void setSystemAffinity(SystemId system_id, SystemAffinity affinity, const std::string &thread_name = "") {
+        sub.setSystemAffinity(system_id, affinity, thread_name);
+    }
+
+    template <class TComponent, class TKeyFunc> void setSortKey(TKeyFunc key_func) {
+        sub.setSortKey<TComponent>(key_func);
+    }
+
+    template <class TComponent> void setEnabled(EntityId id, bool enabled) { sub.setEnabled<TComponent>(id, enabled); }
+    template <class TComponent> bool isEnabled(EntityId id) const { return sub.isEnabled<TComponent>(id); }
+
+    template <class TObserver, class... TComponents>
+    ObserverId registerObserver(TObserver & observer, ObserverTrigger trigger) {
+        return sub.registerObserver<TObserver, TComponents...>(observer, trigger);
+    }
+    void unregisterObserver(ObserverId observer_id) { sub.unregisterObserver(observer_id); }
+
+    void registerEventChannel(EventChannelBase & channel) { sub.registerEventChannel(channel); }
+    void unregisterEventChannel(EventChannelBase & channel) { sub.unregisterEventChannel(channel); }
+
+    void registerIndex(ComponentIndexBase & index) { sub.registerIndex(index); }
+    void unregisterIndex(ComponentIndexBase & index) { sub.unregisterIndex(index); }
+    void refreshIndices() { sub.refreshIndices(); }
+
+    bool saveWorldImage(const std::string &path) { return sub.saveWorldImage(path); }
+    void loadWorldImage(const std::string &path) { sub.loadWorldImage(path); }
 
     void update() { sub.update(); };
 };
@@ -8,6 +8,7 @@
 #include "predefined/transform.hpp"
 
 #include "predefined/camerasystem.hpp"
+#include "predefined/chunkboundssystem.hpp"
 #include "predefined/localtransformsystem.hpp"
 #include "predefined/modelviewtransoformsystem.hpp"
 #include "predefined/modelviewupdatesystem.hpp"
@@ -29,22 +30,36 @@ void ECSPredefinedRegistration::reg() {
     internal::getComponentRegisterer().registerComponent<SimpleModelViewComponent>("simplemodelview");
     internal::getComponentRegisterer().registerComponent<SimpleModelViewUpdateComponent>("simplemodelviewupdate");
     internal::getComponentRegisterer().registerComponent<CameraComponent>("camera");
+    internal::getComponentRegisterer().registerComponent<ChunkBoundsComponent>("chunkbounds");
 
-    GET_MODULE(ECSCore)
-        .registerSystemForce<SimpleModelViewTransformSystem, TransformComponent, SimpleModelViewComponent>(
-            GET_MODULE(SimpleModelViewTransformSystem), {});
-    GET_MODULE(ECSCore).registerSystemForce<CameraSystem, TransformComponent, CameraComponent>(GET_MODULE(CameraSystem),
-                                                                                               {});
-    GET_MODULE(ECSCore)
-        .registerSystemForce<LocalTransformSystem, EntityId, TransformComponent, LocalTransformComponent>(
-            GET_MODULE(LocalTransformSystem), {});
+    // these touch renderer modules, which are not thread safe
+    const auto model_view_transform_system_id =
+        GET_MODULE(ECSCore)
+            .registerSystemForce<SimpleModelViewTransformSystem, const TransformComponent,
+                                 const SimpleModelViewComponent>(GET_MODULE(SimpleModelViewTransformSystem), {});
+    GET_MODULE(ECSCore).setSystemAffinity(model_view_transform_system_id, SystemAffinity::MainThread);
+
+    const auto camera_system_id =
+        GET_MODULE(ECSCore).registerSystemForce<CameraSystem, TransformComponent, CameraComponent>(
+            GET_MODULE(CameraSystem), {});
+    GET_MODULE(ECSCore).setSystemAffinity(camera_system_id, SystemAffinity::MainThread);
 
-    GET_MODULE(ECSCore).registerSystemForce<SimpleCollisionSystem, TransformComponent, SphereColliderComponent>(
-        GET_MODULE(SimpleCollisionSystem), {});
+    const auto local_transform_system_id =
+        GET_MODULE(ECSCore)
+            .registerSystemForce<LocalTransformSystem, const EntityId, TransformComponent,
+                                 const LocalTransformComponent>(
+                GET_MODULE(LocalTransformSystem), {});
+    GET_MODULE(ECSCore).registerSystem<ChunkBoundsSystem, const TransformComponent, ChunkBoundsComponent>(
+        GET_MODULE(ChunkBoundsSystem), {local_transform_system_id});
+
+    GET_MODULE(ECSCore)
+        .registerSystemForce<SimpleCollisionSystem, EntityId, TransformComponent, SphereColliderComponent>(
+            GET_MODULE(SimpleCollisionSystem), {});
+    GET_MODULE(ECSCore).registerEventChannel(GET_MODULE(SimpleCollisionSystem).events());
 
     GET_MODULE(ECSCore)
-        .registerSystemForce<SimpleModelViewUpdateSystem, SimpleModelViewComponent, SimpleModelViewUpdateComponent>(
-            GET_MODULE(SimpleModelViewUpdateSystem), {});
+        .registerObserver<SimpleModelViewUpdateSystem, SimpleModelViewComponent, SimpleModelViewUpdateComponent>(
+            GET_MODULE(SimpleModelViewUpdateSystem), ObserverTrigger::OnAdd);
 }
 
 } // namespace Pelican
@@ -0,0 +1,23 @@
+#include "chunkboundssystem.hpp"
+
+#include <algorithm>
+
+namespace Pelican {
+
+void ChunkBoundsSystem::process(QueryComponents components, size_t count) {
+    auto transforms = std::get<const TransformComponent *>(components);
+    auto &bounds = *std::get<ChunkBoundsComponent *>(components);
+
+    if (count == 0)
+        return;
+
+    glm::vec3 min = transforms[0].pos, max = transforms[0].pos;
+    for (size_t i = 1; i < count; i++) {
+        min = glm::min(min, transforms[i].pos);
+        max = glm::max(max, transforms[i].pos);
+    }
+    bounds.min = vec3{min.x, min.y, min.z};
+    bounds.max = vec3{max.x, max.y, max.z};
+}
+
+} // namespace Pelican
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "../../container.hpp"
+#include <details/ecs/coretemplate.hpp>
+#include <span>
+
+#include "transform.hpp"
+#include <components/chunkbounds.hpp>
+
+namespace Pelican {
+
+DECLARE_MODULE(ChunkBoundsSystem) {
+  public:
+    using QueryComponents = std::tuple<const TransformComponent *, ChunkBoundsComponent *>;
+    void process(QueryComponents components, size_t count);
+};
+
+} // namespace Pelican
@@ -1,15 +1,22 @@
 #include "collision.hpp"
+#include "../../job_system.hpp"
 #define OBJECTS_SIZE 1000000
 
 namespace Pelican {
 
+EventChannel<CollisionEvent> &internal::getCollisionEvents() { return GET_MODULE(SimpleCollisionSystem).events(); }
+
 void SimpleCollisionSystem::process(Query chunks) {
-    std::vector<SphereColliderComponent> world_objects;
+    struct WorldObject {
+        EntityId id;
+        SphereColliderComponent sphere;
+    };
+    std::vector<WorldObject> world_objects;
     world_objects.reserve(OBJECTS_SIZE);
 
     // オブジェクトを列挙(今は球だけ)
     for (auto &chunk : chunks) {
-        auto [transforms, colliders] = chunk.components;
+        auto [ids, transforms, colliders] = chunk.components;
         size_t count = chunk.count;
 
         for (size_t i = 0; i < count; i++) {
@@ -20,32 +27,38 @@ void SimpleCollisionSystem::process(Query chunks) {
             world_pos.y = t.pos.y;
             world_pos.z = t.pos.z;
 
-            world_objects.emplace_back(SphereColliderComponent{
-                .pos = world_pos,
-                .radius = c.radius 
+            world_objects.emplace_back(WorldObject{
+                .id = ids[i],
+                .sphere = SphereColliderComponent{
+                    .pos = world_pos,
+                    .radius = c.radius 
+                },
             });
         }
     }
 
-    // 衝突検出
+    // 衝突検出 (rows get shorter towards the end; parallelFor balances that by stealing)
     size_t count = world_objects.size();
-    for (size_t i = 0; i < count; i++) {
-        for (size_t j = i + 1; j < count; j++) {
-            const auto& s1 = world_objects[i];
-            const auto& s2 = world_objects[j];
-
-            float dx = s1.pos.x - s2.pos.x;
-            float dy = s1.pos.y - s2.pos.y;
-            float dz = s1.pos.z - s2.pos.z;
-            float dist2 = dx*dx + dy*dy + dz*dz;
-            
-            float radSum = s1.radius + s2.radius;
-
-            if (dist2 < (radSum * radSum)) {
-                // 衝突を検出した処理(何書けばいいのかわからん)
+    JobSystem::Get().parallelFor(0, count, 0, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            for (size_t j = i + 1; j < count; j++) {
+                const auto& s1 = world_objects[i].sphere;
+                const auto& s2 = world_objects[j].sphere;
+
+                float dx = s1.pos.x - s2.pos.x;
+                float dy = s1.pos.y - s2.pos.y;
+                float dz = s1.pos.z - s2.pos.z;
+                float dist2 = dx*dx + dy*dy + dz*dz;
+                
+                float radSum = s1.radius + s2.radius;
+
+                if (dist2 < (radSum * radSum)) {
+                    // send() is per job thread, safe from any piece
+                    collision_events.send(CollisionEvent{world_objects[i].id, world_objects[j].id});
+                }
             }
         }
-    }
+    });
 }
 
 }
@@ -8,9 +8,13 @@
 namespace Pelican {
 
 DECLARE_MODULE(SimpleCollisionSystem) {
+    EventChannel<CollisionEvent> collision_events;
+
   public:
-    using Query = std::span<ChunkView<TransformComponent, SphereColliderComponent>>;
+    using Query = std::span<ChunkView<EntityId, TransformComponent, SphereColliderComponent>>;
     void process(Query chunks);
+
+    EventChannel<CollisionEvent> &events() { return collision_events; }
 };
 
 } // namespace Pelican
\ No newline at end of file
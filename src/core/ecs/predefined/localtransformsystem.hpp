@@ -18,7 +18,7 @@ DECLARE_MODULE(LocalTransformSystem) {
     std::vector<bool> tmpappearbuf;
 
   public:
-    using Query = std::span<ChunkView<EntityId, TransformComponent, LocalTransformComponent>>;
+    using Query = std::span<ChunkView<const EntityId, TransformComponent, const LocalTransformComponent>>;
     void process(Query chunks);
 };
 
@@ -5,7 +5,6 @@
 
 namespace Pelican {
 
-void SimpleModelViewComponent::init() {}
 void SimpleModelViewComponent::deinit() {
     if (model_instance_id)
         GET_MODULE(PolygonInstanceContainer).removeModelInstance(*model_instance_id);
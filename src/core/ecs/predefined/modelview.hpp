@@ -12,7 +12,8 @@ struct SimpleModelViewComponent {
 
     template <class T> void ref(T &ar) {}
 
-    void init();
+    // the instance belongs to the renderer of this run: a copied or mapped value must not keep it
+    void init() { model_instance_id.reset(); }
     void deinit();
 };
 
@@ -4,17 +4,13 @@
 
 namespace Pelican {
 
-void SimpleModelViewTransformSystem::process(QueryComponents components, size_t count) {
-    auto transforms = std::get<TransformComponent *>(components);
-    auto models = std::get<SimpleModelViewComponent *>(components);
-
+void SimpleModelViewTransformSystem::process(Query chunk) {
     auto &pic = GET_MODULE(PolygonInstanceContainer);
-    for (int i = 0; i < count; i++) {
-        if (models[i].model_instance_id.has_value()) {
-            pic.setTrs(models[i].model_instance_id.value(), transforms[i].pos, transforms[i].rotation,
-                       transforms[i].scale);
+    chunk.each([&](const TransformComponent &transform, const SimpleModelViewComponent &model) {
+        if (model.model_instance_id.has_value()) {
+            pic.setTrs(model.model_instance_id.value(), transform.pos, transform.rotation, transform.scale);
         }
-    }
+    });
 }
 
 } // namespace Pelican
@@ -11,8 +11,8 @@ namespace Pelican {
 
 DECLARE_MODULE(SimpleModelViewTransformSystem) {
   public:
-    using QueryComponents = std::tuple<TransformComponent *, SimpleModelViewComponent *>;
-    void process(QueryComponents components, size_t count);
+    using Query = ChunkView<const TransformComponent, const SimpleModelViewComponent>;
+    void process(Query chunk);
 };
 
 } // namespace Pelican
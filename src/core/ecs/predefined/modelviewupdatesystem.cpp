@@ -5,21 +5,29 @@
 
 namespace Pelican {
 
-void SimpleModelViewUpdateSystem::process(QueryComponents components, size_t count) {
-    auto mu = std::get<SimpleModelViewUpdateComponent *>(components);
-    auto m = std::get<SimpleModelViewComponent *>(components);
-
-    for (int i = 0; i < count; i++) {
-        if (!mu[i].dirty)
-            continue;
-        if (m[i].model_instance_id.has_value())
-            GET_MODULE(PolygonInstanceContainer).removeModelInstance(m[i].model_instance_id.value());
-
-        auto model_name = mu[i].model_name;
-        auto &model_template = GET_MODULE(ModelAssetContainer).getModelTemplateByName(model_name);
-        m[i].model_instance_id = GET_MODULE(PolygonInstanceContainer).placeModelInstance(model_template);
-        mu[i].dirty = false;
+void SimpleModelViewUpdateSystem::observe(Batches batches) {
+    for (auto &batch : batches) {
+        auto m = std::get<SimpleModelViewComponent *>(batch.components);
+        auto mu = std::get<SimpleModelViewUpdateComponent *>(batch.components);
+
+        for (auto i : batch.rows) {
+            place(m[i], mu[i]);
+        }
     }
 }
 
+void SimpleModelViewUpdateSystem::changeModel(SimpleModelViewComponent &m, SimpleModelViewUpdateComponent &mu,
+                                              const std::string &model_name) {
+    mu.model_name = model_name;
+    place(m, mu);
+}
+
+void SimpleModelViewUpdateSystem::place(SimpleModelViewComponent &m, const SimpleModelViewUpdateComponent &mu) {
+    if (m.model_instance_id.has_value())
+        GET_MODULE(PolygonInstanceContainer).removeModelInstance(m.model_instance_id.value());
+
+    auto &model_template = GET_MODULE(ModelAssetContainer).getModelTemplateByName(mu.model_name);
+    m.model_instance_id = GET_MODULE(PolygonInstanceContainer).placeModelInstance(model_template);
+}
+
 } // namespace Pelican
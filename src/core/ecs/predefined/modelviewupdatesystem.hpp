@@ -9,10 +9,18 @@
 
 namespace Pelican {
 
+// Places model instances of newly created entities (OnAdd observer)
 DECLARE_MODULE(SimpleModelViewUpdateSystem) {
   public:
-    using QueryComponents = std::tuple<SimpleModelViewComponent *, SimpleModelViewUpdateComponent *>;
-    void process(QueryComponents components, size_t count);
+    using Batches = std::span<ObserverBatch<SimpleModelViewComponent, SimpleModelViewUpdateComponent>>;
+    void observe(Batches batches);
+
+    // Swap the model of an entity which was already placed, e.g. from a SystemAffinity::MainThread system
+    // querying both components. Renderer modules are not thread safe: call it on the main thread only.
+    void changeModel(SimpleModelViewComponent &m, SimpleModelViewUpdateComponent &mu, const std::string &model_name);
+
+  private:
+    void place(SimpleModelViewComponent &m, const SimpleModelViewUpdateComponent &mu);
 };
 
 } // namespace Pelican
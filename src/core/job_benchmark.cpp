@@ -0,0 +1,161 @@
+#include "job_system.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace Pelican;
+
+namespace {
+
+// The previous JobSystem design (one mutex protected queue, notify on every completion), kept as the baseline
+class LockedQueuePool {
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> jobs;
+    std::mutex queue_mutex;
+    std::condition_variable condition;
+    bool stop = false;
+    int active_jobs = 0;
+    std::mutex wait_mutex;
+    std::condition_variable wait_condition;
+
+  public:
+    explicit LockedQueuePool(int thread_count) {
+        for (int i = 0; i < thread_count; i++) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock<std::mutex> lock(queue_mutex);
+                        condition.wait(lock, [this] { return stop || !jobs.empty(); });
+                        if (stop && jobs.empty()) return;
+                        job = std::move(jobs.front());
+                        jobs.pop();
+                    }
+                    job();
+                    std::lock_guard<std::mutex> lock(wait_mutex);
+                    active_jobs--;
+                    wait_condition.notify_all();
+                }
+            });
+        }
+    }
+    ~LockedQueuePool() {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            stop = true;
+        }
+        condition.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    void schedule(std::function<void()> job) {
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            jobs.push(std::move(job));
+        }
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            active_jobs++;
+        }
+        condition.notify_one();
+    }
+    void wait() {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        wait_condition.wait(lock, [this] { return active_jobs == 0; });
+    }
+};
+
+struct WorkStealingPool {
+    explicit WorkStealingPool(int thread_count) { JobSystem::Get().init(thread_count, 0); }
+    ~WorkStealingPool() { JobSystem::Get().cleanup(); }
+    template <class F> void schedule(F &&job) { JobSystem::Get().schedule(std::forward<F>(job)); }
+    void wait() { JobSystem::Get().wait(); }
+};
+
+// ~100ns of arithmetic, small enough that scheduling overhead dominates
+void work(int iterations) {
+    volatile uint32_t x = 1;
+    for (int i = 0; i < iterations; i++)
+        x = x * 1664525u + 1013904223u;
+}
+
+constexpr int FLAT_JOBS = 200000;
+constexpr int NESTED_PARENTS = 1000;
+constexpr int NESTED_CHILDREN = 200;
+constexpr int WORK_ITERATIONS = 200;
+constexpr int REPEAT = 3;
+
+// every job is submitted from the main thread
+template <class TPool> double runFlat(TPool &pool) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < FLAT_JOBS; i++)
+        pool.schedule([] { work(WORK_ITERATIONS); });
+    pool.wait();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// jobs spawn their own children (the pattern of parallel systems splitting chunks)
+template <class TPool> double runNested(TPool &pool) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < NESTED_PARENTS; i++) {
+        pool.schedule([&pool] {
+            for (int k = 0; k < NESTED_CHILDREN; k++)
+                pool.schedule([] { work(WORK_ITERATIONS); });
+        });
+    }
+    pool.wait();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+template <class TPool> double best(int thread_count, double (*scenario)(TPool &)) {
+    TPool pool{thread_count};
+    double result = 1e30;
+    for (int r = 0; r < REPEAT; r++)
+        result = std::min(result, scenario(pool));
+    return result;
+}
+
+void report(const char *name, double (*locked)(LockedQueuePool &), double (*stealing)(WorkStealingPool &),
+            int job_count, const std::vector<int> &thread_counts) {
+    std::printf("\n[%s] %d jobs of ~%d iterations\n", name, job_count, WORK_ITERATIONS);
+    std::printf("%8s | %12s %10s | %12s %10s\n", "threads", "locked ms", "efficiency", "stealing ms", "efficiency");
+
+    double locked_base = 0, stealing_base = 0;
+    for (int threads : thread_counts) {
+        const double locked_ms = best<LockedQueuePool>(threads, locked);
+        const double stealing_ms = best<WorkStealingPool>(threads, stealing);
+        if (threads == thread_counts.front()) {
+            locked_base = locked_ms * threads;
+            stealing_base = stealing_ms * threads;
+        }
+        // efficiency = speedup / threads, relative to the smallest thread count
+        std::printf("%8d | %12.2f %9.0f%% | %12.2f %9.0f%%\n", threads, locked_ms,
+                    100.0 * locked_base / (locked_ms * threads), stealing_ms,
+                    100.0 * stealing_base / (stealing_ms * threads));
+    }
+}
+
+} // namespace
+
+// usage: job_benchmark [max_threads]
+int main(int argc, char **argv) {
+    const int hardware = argc > 1 ? std::max(1, std::atoi(argv[1]))
+                                  : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> thread_counts;
+    for (int t = 1; t < hardware; t *= 2)
+        thread_counts.push_back(t);
+    thread_counts.push_back(hardware);
+
+    report("flat", runFlat<LockedQueuePool>, runFlat<WorkStealingPool>, FLAT_JOBS, thread_counts);
+    report("nested", runNested<LockedQueuePool>, runNested<WorkStealingPool>, NESTED_PARENTS * NESTED_CHILDREN,
+           thread_counts);
+    return 0;
+}
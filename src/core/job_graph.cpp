@@ -0,0 +1,172 @@
+#include "job_graph.hpp"
+#include <stdexcept>
+
+namespace Pelican {
+
+TaskGraph::NodeId TaskGraph::addNode(std::string name, std::function<void()> fn, size_t thread, JobPriority priority) {
+    if (running())
+        throw std::runtime_error("TaskGraph modified while running");
+    auto &node = nodes.emplace_back();
+    node.name = std::move(name);
+    node.fn = std::move(fn);
+    node.thread = thread;
+    node.priority = priority;
+    prepared = false;
+    return nodes.size() - 1;
+}
+
+TaskGraph::NodeId TaskGraph::addSyncPoint(std::string name) { return addNode(std::move(name), nullptr); }
+
+void TaskGraph::addEdge(NodeId before, NodeId after) {
+    if (running())
+        throw std::runtime_error("TaskGraph modified while running");
+    nodes.at(before).successors.push_back(after);
+    nodes.at(after).predecessor_count++;
+    prepared = false;
+}
+
+void TaskGraph::clear() {
+    if (running())
+        throw std::runtime_error("TaskGraph modified while running");
+    nodes.clear();
+    roots.clear();
+    caller_ready.clear();
+    caller_node_count = 0;
+    prepared = false;
+}
+
+void TaskGraph::prepare() {
+    // Kahn's algorithm on a copy of the counters; nodes never reached are on a cycle
+    std::vector<int> unmet(nodes.size());
+    std::vector<NodeId> order;
+    order.reserve(nodes.size());
+    roots.clear();
+    caller_node_count = 0;
+    for (NodeId id = 0; id < nodes.size(); id++) {
+        unmet[id] = nodes[id].predecessor_count;
+        if (unmet[id] == 0) {
+            roots.push_back(id);
+            order.push_back(id);
+        }
+        if (nodes[id].thread == CALLER) caller_node_count++;
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+        for (const NodeId next : nodes[order[i]].successors) {
+            if (--unmet[next] == 0) order.push_back(next);
+        }
+    }
+    if (order.size() != nodes.size()) {
+        LOG_ERROR(logger, "TaskGraph: {} nodes are part of a cycle", nodes.size() - order.size());
+        throw std::runtime_error("TaskGraph has a cycle");
+    }
+
+    caller_ready.reserve(caller_node_count);
+    prepared = true;
+}
+
+bool TaskGraph::running() const {
+    return (counter && !counter->done()) || caller_remaining.load(std::memory_order_acquire) != 0;
+}
+
+void TaskGraph::start() {
+    if (running())
+        throw std::runtime_error("TaskGraph started while running");
+    if (!prepared) prepare();
+
+    for (auto &node : nodes) {
+        node.remaining.store(node.predecessor_count, std::memory_order_relaxed);
+    }
+    caller_remaining.store(static_cast<int>(caller_node_count), std::memory_order_relaxed);
+    counter = JobHandle::create();
+    for (const NodeId root : roots) {
+        startNode(root);
+    }
+}
+
+void TaskGraph::startNode(NodeId id) {
+    Node &node = nodes[id];
+    if (!node.fn) {
+        runNode(id);
+    } else if (node.thread == CALLER) {
+        std::lock_guard<std::mutex> lock(caller_mutex);
+        caller_ready.push_back(id);
+    } else {
+        JobSystem::Get().scheduleInto(counter, [this, id] { runNode(id); }, {}, node.thread, node.priority);
+    }
+}
+
+void TaskGraph::runNode(NodeId id) {
+    Node &node = nodes[id];
+    if (node.fn) {
+        // successors are released anyway, a failed node must not stall the graph
+        try {
+            node.fn();
+        } catch (const std::exception &e) {
+            LOG_ERROR(logger, "TaskGraph: node [{}] failed: {}", node.name, e.what());
+        } catch (...) {
+            LOG_ERROR(logger, "TaskGraph: node [{}] failed", node.name);
+        }
+    }
+    // successors are scheduled into the counter before this job finishes, so it can't complete early
+    for (const NodeId next : node.successors) {
+        if (nodes[next].remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) startNode(next);
+    }
+    if (node.thread == CALLER) caller_remaining.fetch_sub(1, std::memory_order_release);
+}
+
+JobHandle TaskGraph::launch() {
+    if (!prepared) prepare();
+    if (caller_node_count != 0)
+        throw std::runtime_error("TaskGraph with caller nodes must be started with run()");
+    start();
+    return counter;
+}
+
+void TaskGraph::run() {
+    start();
+    while (true) {
+        NodeId id = 0;
+        bool ready = false;
+        {
+            std::lock_guard<std::mutex> lock(caller_mutex);
+            if (!caller_ready.empty()) {
+                id = caller_ready.back();
+                caller_ready.pop_back();
+                ready = true;
+            }
+        }
+        if (ready) {
+            runNode(id);
+            continue;
+        }
+        // once the caller nodes are done, the rest is an ordinary wait
+        if (caller_remaining.load(std::memory_order_acquire) == 0) break;
+        if (!JobSystem::Get().runPendingJob()) std::this_thread::yield();
+    }
+    JobSystem::Get().wait(counter);
+}
+
+std::string TaskGraph::toDot() const {
+    const auto quoted = [](const std::string &s) {
+        std::string out = "\"";
+        for (const char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    };
+
+    std::string dot = "digraph TaskGraph {\n";
+    for (NodeId id = 0; id < nodes.size(); id++) {
+        const auto &node = nodes[id];
+        const char *shape = !node.fn ? "diamond" : node.thread == CALLER ? "doubleoctagon" : "box";
+        dot += "  n" + std::to_string(id) + " [label=" + quoted(node.name) + ", shape=" + shape + "];\n";
+    }
+    for (NodeId id = 0; id < nodes.size(); id++) {
+        for (const NodeId next : nodes[id].successors)
+            dot += "  n" + std::to_string(id) + " -> n" + std::to_string(next) + ";\n";
+    }
+    return dot + "}\n";
+}
+
+} // namespace Pelican
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "job_system.hpp"
+
+namespace Pelican {
+
+// Graph of jobs declared once and run many times, e.g. the work of a frame.
+// Dependency counters are reset in place on every run, and a node is pushed to the job queues as soon as its
+// last predecessor finishes, so running the graph neither rebuilds nor allocates anything.
+// Not thread safe: build and run it from one thread.
+class TaskGraph {
+  public:
+    using NodeId = size_t;
+
+    // Node thread: runs on the thread calling run(), e.g. main thread ECS systems
+    static constexpr size_t CALLER = static_cast<size_t>(-3);
+
+    // thread is JobSystem::ANY_WORKER, a dedicated thread, JobSystem::MAIN_THREAD or CALLER;
+    // priority only applies to ANY_WORKER nodes
+    NodeId addNode(std::string name, std::function<void()> fn, size_t thread = JobSystem::ANY_WORKER,
+                   JobPriority priority = JobPriority::Normal);
+    // Node without work joining a group of nodes; completes inline as soon as its predecessors have
+    NodeId addSyncPoint(std::string name);
+    // after starts once before has finished
+    void addEdge(NodeId before, NodeId after);
+    void clear();
+
+    // Starts every node without predecessors; the handle completes when every node has finished.
+    // Graphs with CALLER nodes need run() instead.
+    JobHandle launch();
+    // launch() and wait for the whole graph, running CALLER nodes and other pending jobs meanwhile
+    void run();
+    bool running() const;
+
+    size_t nodeCount() const { return nodes.size(); }
+    const std::string &nodeName(NodeId id) const { return nodes[id].name; }
+    std::span<const NodeId> successors(NodeId id) const { return nodes[id].successors; }
+    // Graphviz description of the graph
+    std::string toDot() const;
+
+  private:
+    struct Node {
+        std::string name;
+        std::function<void()> fn; // empty for sync points
+        size_t thread;
+        JobPriority priority;
+        std::vector<NodeId> successors;
+        int predecessor_count = 0;
+        std::atomic<int> remaining{0};
+    };
+
+    void prepare();
+    void start();
+    void startNode(NodeId id);
+    void runNode(NodeId id);
+
+    std::deque<Node> nodes; // never moved, remaining is atomic
+    std::vector<NodeId> roots;
+    size_t caller_node_count = 0;
+    bool prepared = false;
+
+    JobHandle counter; // of the current run
+    std::atomic<int> caller_remaining{0};
+    std::mutex caller_mutex;
+    std::vector<NodeId> caller_ready; // reserved for every CALLER node
+};
+
+} // namespace Pelican
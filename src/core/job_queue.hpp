@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Pelican {
+
+// Chase-Lev work-stealing deque of pointers.
+// The owner thread pushes and pops at the bottom (LIFO); any other thread steals from the top (FIFO).
+// Old rings are kept until destruction because a thief may still be reading one after the owner grew it.
+template <class T> class WorkStealingDeque {
+    struct Ring {
+        int64_t capacity;
+        std::unique_ptr<std::atomic<T *>[]> slots;
+
+        explicit Ring(int64_t _capacity) : capacity{_capacity}, slots{new std::atomic<T *>[_capacity]} {}
+
+        T *get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t i, T *item) { slots[i & (capacity - 1)].store(item, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    alignas(64) std::atomic<Ring *> ring;
+    std::vector<std::unique_ptr<Ring>> rings; // owner only
+
+    Ring *grow(Ring *old, int64_t b, int64_t t) {
+        auto &bigger = rings.emplace_back(std::make_unique<Ring>(old->capacity * 2));
+        for (int64_t i = t; i < b; i++)
+            bigger->put(i, old->get(i));
+        return bigger.get();
+    }
+
+  public:
+    explicit WorkStealingDeque(int64_t capacity = 1024) {
+        rings.emplace_back(std::make_unique<Ring>(capacity));
+        ring.store(rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // owner only
+    void push(T *item) {
+        const int64_t b = bottom.load(std::memory_order_relaxed);
+        const int64_t t = top.load(std::memory_order_acquire);
+        Ring *r = ring.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow(r, b, t);
+            ring.store(r, std::memory_order_release);
+        }
+        r->put(b, item);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only; nullptr when empty
+    T *pop() {
+        const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring *r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T *item = r->get(b);
+        if (t == b) {
+            // last item: race against thieves
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread; nullptr when empty or when another thief won the race
+    T *steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        T *item = ring.load(std::memory_order_acquire)->get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+    // approximate when read by another thread than the owner
+    size_t size() const {
+        const int64_t n = bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+};
+
+// Bounded lock-free multi-producer multi-consumer queue of pointers (Vyukov).
+// Used for jobs submitted by threads that don't own a deque.
+template <class T> class InjectionQueue {
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T *item;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+
+  public:
+    // capacity must be a power of two
+    explicit InjectionQueue(size_t capacity = 8192) : cells{new Cell[capacity]}, mask{capacity - 1} {
+        for (size_t i = 0; i < capacity; i++)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // false when full
+    bool push(T *item) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // approximate when other threads push or pop concurrently
+    bool empty() const {
+        return dequeue_pos.load(std::memory_order_relaxed) >= enqueue_pos.load(std::memory_order_relaxed);
+    }
+    size_t size() const {
+        const size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+        const size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    // nullptr when empty
+    T *pop() {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & mask];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    T *item = cell.item;
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return item;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+} // namespace Pelican
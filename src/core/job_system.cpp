@@ -1,88 +1,848 @@
 #include "job_system.hpp"
+#include "os/thread.hpp"
+#include "profiler.hpp"
+#include <algorithm>
 #include <iostream>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#endif
+
 namespace Pelican {
 
+namespace {
+thread_local size_t tls_thread_index = 0;
+thread_local uint32_t tls_steal_seed = 0;
+thread_local bool tls_background_worker = false;
+// priority of the job running on this thread; code outside of jobs (main loop) is frame critical
+thread_local JobPriority tls_job_priority = JobPriority::Critical;
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsedNs(Clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count();
+}
+
+// Counters of one thread, written by that thread only and read by JobSystem::collectStats()
+struct ThreadCounters {
+    std::string name;
+    size_t thread_index;
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> idle_ns{0};
+    std::atomic<uint64_t> lock_wait_ns{0};
+    std::atomic<uint64_t> jobs_run{0};
+    std::atomic<uint64_t> jobs_stolen{0};
+    JobThreadStats reported; // totals at the previous collection, collector only
+
+    static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+        // single writer: no read-modify-write needed
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+};
+
+// Counters of every thread that has used the job system; never destroyed, like the thread caches
+class CounterRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadCounters>> threads;
+
+  public:
+    static CounterRegistry &Get() {
+        static CounterRegistry *instance = new CounterRegistry;
+        return *instance;
+    }
+
+    ThreadCounters *add(std::string name, size_t thread_index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &counters = *threads.emplace_back(std::make_unique<ThreadCounters>());
+        counters.name = std::move(name);
+        counters.thread_index = thread_index;
+        return &counters;
+    }
+
+    template <class F> void forEach(F &&f) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &counters : threads) {
+            f(*counters);
+        }
+    }
+};
+
+thread_local ThreadCounters *tls_counters = nullptr;
+// nesting of runJob() on this thread; helping inside a job is neither busy nor idle time of its own
+thread_local int tls_job_depth = 0;
+
+ThreadCounters &threadCounters() {
+    // job system threads register by name when they start, other threads on first use
+    if (!tls_counters) {
+        tls_counters = CounterRegistry::Get().add(JobSystem::Get().isMainThread() ? "main" : "external",
+                                                  tls_thread_index);
+    }
+    return *tls_counters;
+}
+
+// Only reads the clock when the mutex is contended
+template <class M> std::unique_lock<M> timedLock(M &mutex) {
+    std::unique_lock<M> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        const auto start = Clock::now();
+        lock.lock();
+        ThreadCounters::add(threadCounters().lock_wait_ns, elapsedNs(start));
+    }
+    return lock;
+}
+
+void notePeak(std::atomic<size_t> &peak, size_t depth) {
+    // approximate: concurrent writers may lose an update
+    if (depth > peak.load(std::memory_order_relaxed)) peak.store(depth, std::memory_order_relaxed);
+}
+
+// pause instructions between two looks for work while spinning (about a microsecond)
+constexpr int PAUSES_PER_POLL = 8;
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#elif defined(_M_ARM64)
+    __yield();
+#endif
+}
+
+// Idle phases of a thread looking for work: spin, then yield, then sleep
+class IdleBackoff {
+    const JobIdlePolicy &policy;
+    Clock::time_point idle_since;
+    bool idle = false;
+
+  public:
+    explicit IdleBackoff(const JobIdlePolicy &_policy) : policy{_policy} {}
+    ~IdleBackoff() { reset(); }
+
+    // End of an idle period (a job was found, or the thread woke up)
+    void reset() {
+        if (idle && tls_job_depth == 0) ThreadCounters::add(threadCounters().idle_ns, elapsedNs(idle_since));
+        idle = false;
+    }
+
+    // Waits a little after a failed look for work; false once the caller should sleep instead
+    bool backoff(bool stay_hot) {
+        const auto now = Clock::now();
+        if (!idle) {
+            idle = true;
+            idle_since = now;
+        }
+        const auto elapsed = now - idle_since;
+        if (elapsed < policy.spin) {
+            for (int i = 0; i < PAUSES_PER_POLL; i++) {
+                cpuRelax();
+            }
+            return true;
+        }
+        if (stay_hot || elapsed < policy.spin + policy.yield) {
+            std::this_thread::yield();
+            return true;
+        }
+        return false;
+    }
+};
+
+void setupThread(const std::string &name, size_t thread_index, std::span<const int> cpus) {
+    tls_thread_index = thread_index;
+    tls_counters = CounterRegistry::Get().add(name, thread_index);
+    setCurrentThreadName(name);
+    if (!cpus.empty() && !pinCurrentThread(cpus)) {
+        LOG_WARNING(logger, "JobSystem: failed to pin thread {} to CPU {}", name, cpus[0]);
+    }
+}
+
+uint32_t nextVictimSeed() {
+    // xorshift32, seeded per thread
+    uint32_t x = tls_steal_seed ? tls_steal_seed : static_cast<uint32_t>(tls_thread_index * 2654435761u + 1);
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return tls_steal_seed = x;
+}
+
+// Freelist of records linked through their Next member, never returned to the heap.
+// Records are usually freed on another thread than the one that allocated them (scheduled here,
+// finished there), so each thread keeps a small cache and trades whole batches with a shared list.
+template <class T, T *T::*Next> class RecordPool {
+    static constexpr size_t BATCH = 64;
+
+    struct Batch {
+        T *head;
+        size_t count;
+    };
+    struct Cache {
+        RecordPool *pool;
+        T *head = nullptr;
+        size_t count = 0;
+
+        ~Cache() {
+            if (head) pool->giveBatch({head, count});
+        }
+    };
+
+    std::mutex mutex;
+    std::vector<Batch> batches;
+
+    Cache &localCache() {
+        thread_local Cache cache{this};
+        return cache;
+    }
+
+    void giveBatch(Batch batch) {
+        const auto lock = timedLock(mutex);
+        batches.push_back(batch);
+    }
+
+    void refill(Cache &cache) {
+        {
+            const auto lock = timedLock(mutex);
+            if (!batches.empty()) {
+                cache.head = batches.back().head;
+                cache.count = batches.back().count;
+                batches.pop_back();
+                return;
+            }
+        }
+        for (size_t i = 0; i < BATCH; i++) {
+            T *record = new T;
+            record->*Next = cache.head;
+            cache.head = record;
+        }
+        cache.count = BATCH;
+    }
+
+  public:
+    // never destroyed: thread caches hand their records back at thread exit
+    static RecordPool &Get() {
+        static RecordPool *instance = new RecordPool;
+        return *instance;
+    }
+
+    T *alloc() {
+        Cache &cache = localCache();
+        if (!cache.head) refill(cache);
+        T *record = cache.head;
+        cache.head = record->*Next;
+        cache.count--;
+        return record;
+    }
+
+    void free(T *record) {
+        Cache &cache = localCache();
+        record->*Next = cache.head;
+        cache.head = record;
+        if (++cache.count < 2 * BATCH) return;
+
+        // keep one batch, give the other one away
+        T *last = cache.head;
+        for (size_t i = 1; i < BATCH; i++)
+            last = last->*Next;
+        const Batch batch{cache.head, BATCH};
+        cache.head = last->*Next;
+        cache.count -= BATCH;
+        last->*Next = nullptr;
+        giveBatch(batch);
+    }
+};
+}
+
+JobCounter *JobSystem::allocCounter() {
+    JobCounter *counter = RecordPool<JobCounter, &JobCounter::pool_next>::Get().alloc();
+    counter->refs.store(1, std::memory_order_relaxed);
+    counter->pending.store(0, std::memory_order_relaxed);
+    counter->has_continuations.store(false, std::memory_order_relaxed);
+    return counter;
+}
+
+void JobSystem::freeCounter(JobCounter *counter) { RecordPool<JobCounter, &JobCounter::pool_next>::Get().free(counter); }
+
+JobSystem::Job *JobSystem::allocJob() { return RecordPool<Job, &Job::next>::Get().alloc(); }
+
+void JobSystem::freeJob(Job *job) { RecordPool<Job, &Job::next>::Get().free(job); }
+
+void JobSystem::JobList::push(Job *job) {
+    job->next = nullptr;
+    if (tail) tail->next = job;
+    else head = job;
+    tail = job;
+    count++;
+}
+
+JobSystem::Job *JobSystem::JobList::pop() {
+    Job *job = head;
+    if (!job) return nullptr;
+    head = job->next;
+    if (!head) tail = nullptr;
+    count--;
+    return job;
+}
+
+bool JobCounter::addContinuation(Job *job) {
+    const auto lock = timedLock(mutex);
+    // pairs with the seq_cst decrement in JobSystem::finishJob: either this sees the counter completed,
+    // or the completing thread sees the flag and takes the lock
+    has_continuations.store(true, std::memory_order_seq_cst);
+    if (pending.load(std::memory_order_seq_cst) == 0) return false;
+    continuations.push_back(job);
+    return true;
+}
+
 JobSystem::~JobSystem() {
     cleanup();
 }
 
-void JobSystem::init(int thread_count) {
+void JobSystem::init(int thread_count, int background_thread_count) {
+    JobSystemConfig config;
+    config.worker_count = thread_count;
+    config.background_worker_count = background_thread_count;
+    init(config);
+}
+
+void JobSystem::init(const JobSystemConfig &config) {
     if (!workers.empty()) return; // Already initialized
+    main_thread = std::this_thread::get_id();
+
+    const int hardware = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    int thread_count = config.worker_count;
+    // background jobs can run for a long time, so only background workers run them and there is always one
+    int background_thread_count = config.background_worker_count;
+    if (background_thread_count == 0) {
+        LOG_WARNING(logger, "JobSystem: at least one background worker is required, starting one");
+    }
+    background_thread_count = std::max(1, background_thread_count);
 
+    // CPU of each worker (unpinned past the end); background workers share background_cpus
+    std::vector<int> worker_cpus;
+    std::vector<int> background_cpus;
+    if (config.pinning == JobThreadPinning::PhysicalCores) {
+        std::vector<int> performance_cpus;
+        for (const auto &core : physicalCores()) {
+            (core.efficiency ? background_cpus : performance_cpus).push_back(core.cpu);
+        }
+        if (performance_cpus.empty()) {
+            LOG_WARNING(logger, "JobSystem: CPU topology unknown, workers are not pinned");
+        } else {
+            // the first core is left to the main thread and SMT siblings to the OS; background workers share the
+            // efficiency cores (unpinned when there are none)
+            worker_cpus.assign(performance_cpus.begin() + 1, performance_cpus.end());
+            if (thread_count <= 0) thread_count = std::max<int>(1, worker_cpus.size());
+        }
+    } else if (config.pinning == JobThreadPinning::CpuList) {
+        worker_cpus = config.cpus;
+        if (thread_count <= 0) thread_count = std::max<int>(1, worker_cpus.size());
+    }
     if (thread_count <= 0) {
-        thread_count = std::thread::hardware_concurrency();
-        if (thread_count == 0) thread_count = 1;
-        // Reserve one thread for main thread if possible, or just use all logical cores?
-        // Usually, for job system, we want to convert main thread to worker or have N-1 workers.
-        // For simplicity, let's create N-1 workers if N > 1.
-        if (thread_count > 1) thread_count--;
+        // N-1 workers: the thread calling wait() runs jobs as well
+        thread_count = std::max(1, hardware - 1 - background_thread_count);
     }
 
+    // every deque (and the worker counts) must be set before any worker starts
+    background_worker_count = background_thread_count;
+    idle_policy = config.idle;
+    stats_since = Clock::now();
     for (int i = 0; i < thread_count; ++i) {
-        workers.emplace_back([this, i] {
-            while (true) {
-                std::function<void()> job;
-                {
-                    std::unique_lock<std::mutex> lock(queue_mutex);
-                    condition.wait(lock, [this] { return stop || !jobs.empty(); });
-                    
-                    if (stop && jobs.empty()) return;
-                    
-                    job = std::move(jobs.front());
-                    jobs.pop();
-                }
-                
-                try {
-                    //LOG_INFO(logger, "JobSystem: Worker {} starting job", i);
-                    job();
-                    //LOG_INFO(logger, "JobSystem: Worker {} finished job", i);
-                } catch (const std::exception& e) {
-                   LOG_ERROR(logger, "JobSystem Exception: {}", e.what());
-                } catch (...) {
-                   LOG_ERROR(logger, "JobSystem Unknown Exception");
-                }
-                
-                {
-                    std::lock_guard<std::mutex> lock(wait_mutex);
-                    active_jobs--;
-                    wait_condition.notify_all();
-                }
-            }
+        workers.emplace_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        std::vector<int> cpus;
+        if (i < static_cast<int>(worker_cpus.size())) cpus.push_back(worker_cpus[i]);
+        workers[i]->thread = std::thread([this, i, cpus] {
+            setupThread("job-worker-" + std::to_string(i), i + 1, cpus);
+            workerLoop(i);
+        });
+    }
+    for (int i = 0; i < background_thread_count; ++i) {
+        const size_t thread_index = workers.size() + 1 + i;
+        background_workers.emplace_back([this, i, thread_index, background_cpus] {
+            setupThread("job-bg-" + std::to_string(i), thread_index, background_cpus);
+            backgroundWorkerLoop(thread_index);
         });
     }
+    LOG_INFO(logger, "JobSystem: {} workers ({} pinned), {} background workers", thread_count,
+             std::min<size_t>(thread_count, worker_cpus.size()), background_thread_count);
+}
+
+template <class FFind> void JobSystem::runLoop(WakeSignal &signal, bool frame_worker, FFind &&find) {
+    IdleBackoff idle{idle_policy};
+    while (true) {
+        Job *job = find();
+        if (!job) {
+            if (stop.load(std::memory_order_acquire)) return;
+            if (idle.backoff(frame_worker && hotPhase())) continue;
+
+            // park: read the epoch first, so a job pushed after the last look changes it and wait() returns
+            const uint32_t epoch = signal.epoch.load(std::memory_order_seq_cst);
+            signal.sleeping.fetch_add(1, std::memory_order_seq_cst);
+            job = find();
+            if (!job && !stop.load(std::memory_order_seq_cst)) signal.epoch.wait(epoch, std::memory_order_seq_cst);
+            signal.sleeping.fetch_sub(1, std::memory_order_relaxed);
+            idle.reset();
+            if (!job) continue;
+        }
+
+        idle.reset();
+        runJob(*job);
+        finishJob(job);
+    }
 }
 
-void JobSystem::schedule(std::function<void()> job) {
+void JobSystem::workerLoop(size_t worker) {
+    tls_thread_index = worker + 1;
+    runLoop(worker_signal, true, [this, worker] { return findJob(worker); });
+}
+
+void JobSystem::backgroundWorkerLoop(size_t thread_index) {
+    tls_thread_index = thread_index;
+    tls_background_worker = true;
+    runLoop(background_signal, false, [this] { return background.pop(); });
+}
+
+JobSystem::Job *JobSystem::findJob(size_t worker) {
+    Worker *own = worker < workers.size() ? workers[worker].get() : nullptr;
+    // frame critical work first, wherever it is queued
+    if (critical_queued.load(std::memory_order_relaxed) != 0) {
+        Job *job = own ? own->deques[CRITICAL].pop() : nullptr;
+        if (!job) job = injected[CRITICAL].pop();
+        if (!job) job = stealJob(worker, CRITICAL);
+        if (job) {
+            critical_queued.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    if (own) {
+        if (Job *job = own->deques[NORMAL].pop()) return job;
+    }
+    if (Job *job = injected[NORMAL].pop()) return job;
+    return stealJob(worker, NORMAL);
+}
+
+JobSystem::Job *JobSystem::stealJob(size_t thief, size_t level) {
+    const size_t count = workers.size();
+    if (count == 0) return nullptr;
+    const size_t start = nextVictimSeed() % count;
+    for (size_t i = 0; i < count; i++) {
+        const size_t victim = (start + i) % count;
+        if (victim == thief) continue;
+        if (Job *job = workers[victim]->deques[level].steal()) {
+            ThreadCounters::add(threadCounters().jobs_stolen, 1);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+JobSystem::Job *JobSystem::findJobToHelp() {
+    // dedicated thread jobs never enter these queues, so helping keeps their affinity.
+    // Background jobs are left to the background workers: a frame waiting on a level must not pick one up.
+    if (tls_background_worker) return background.pop();
+
+    const size_t index = tls_thread_index;
+    if (index >= 1 && index <= workers.size()) return findJob(index - 1);
+    return findJob(workers.size()); // owns no deque
+
+}
+
+void JobSystem::helpUntil(const std::atomic<int> &remaining_jobs, bool run_main_jobs) {
+    IdleBackoff idle{idle_policy};
+    while (true) {
+        if (run_main_jobs && runOneMainThreadJob()) {
+            idle.reset();
+            continue;
+        }
+        if (Job *job = findJobToHelp()) {
+            idle.reset();
+            runJob(*job);
+            finishJob(job);
+            continue;
+        }
+
+        if (remaining_jobs.load(std::memory_order_acquire) == 0) return;
+        // main thread jobs may still arrive, so that case never sleeps
+        if (idle.backoff(run_main_jobs || (!tls_background_worker && hotPhase()))) continue;
+
+        // What is left is running elsewhere or waits on dependencies. Park like an idle worker, so that the
+        // job released by those dependencies wakes this thread too (it may be the only one that can run it),
+        // and finishJob() bumps the same epoch when a counter completes.
+        WakeSignal &signal = tls_background_worker ? background_signal : worker_signal;
+        const uint32_t epoch = signal.epoch.load(std::memory_order_seq_cst);
+        signal.sleeping.fetch_add(1, std::memory_order_seq_cst);
+        parked_helpers.fetch_add(1, std::memory_order_seq_cst);
+        Job *job = findJobToHelp();
+        if (!job && remaining_jobs.load(std::memory_order_seq_cst) != 0) signal.epoch.wait(epoch, std::memory_order_seq_cst);
+        parked_helpers.fetch_sub(1, std::memory_order_relaxed);
+        signal.sleeping.fetch_sub(1, std::memory_order_relaxed);
+        idle.reset();
+        if (job) {
+            runJob(*job);
+            finishJob(job);
+        }
+    }
+}
+
+bool JobSystem::runPendingJob() {
+    Job *job = findJobToHelp();
+    if (!job) return false;
+    runJob(*job);
+    finishJob(job);
+    return true;
+}
+
+void JobSystem::submit(Job *job, std::span<const JobHandle> dependencies) {
+    active_jobs.fetch_add(1, std::memory_order_relaxed);
+    job->counter->pending.fetch_add(1, std::memory_order_relaxed);
+
+    // the extra count keeps the job from starting while its dependencies are being registered
+    job->unmet_dependencies.store(1, std::memory_order_relaxed);
+    for (const auto &dependency : dependencies) {
+        if (!dependency) continue;
+        job->unmet_dependencies.fetch_add(1, std::memory_order_relaxed);
+        if (!dependency->addContinuation(job)) job->unmet_dependencies.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (job->unmet_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) push(job);
+}
+
+void JobSystem::push(Job *job) {
+    if (job->thread == MAIN_THREAD) {
+        const auto lock = timedLock(main_mutex);
+        main_jobs.push(job);
+        return;
+    }
+    if (job->thread != ANY_WORKER) {
+        auto &dt = *dedicated[job->thread];
+        {
+            const auto lock = timedLock(dt.mutex);
+            dt.jobs.push(job);
+        }
+        dt.condition.notify_one();
+        return;
+    }
+
+    if (job->priority == JobPriority::Background) {
+        // bounded as well; only background workers may drain it. A background worker pushing into a full queue
+        // may be the only one, so it drains it itself instead of waiting for room.
+        while (!background.push(job)) {
+            if (!tls_background_worker) {
+                std::this_thread::yield();
+            } else if (Job *other = background.pop()) {
+                runJob(*other);
+                finishJob(other);
+            }
+        }
+        notePeak(background_peak_depth, background.size());
+        background_signal.wake();
+        return;
+    }
+
+    const size_t level = job->priority == JobPriority::Critical ? CRITICAL : NORMAL;
+    if (level == CRITICAL) critical_queued.fetch_add(1, std::memory_order_relaxed);
+
+    const size_t index = tls_thread_index;
+    if (index >= 1 && index <= workers.size()) {
+        auto &worker = *workers[index - 1];
+        worker.deques[level].push(job);
+        notePeak(worker.peak_depth, worker.deques[CRITICAL].size() + worker.deques[NORMAL].size());
+    } else {
+        // the injection queue is bounded; when it is full, help draining it
+        while (!injected[level].push(job)) {
+            if (Job *other = findJob(workers.size())) {
+                runJob(*other);
+                finishJob(other);
+            }
+        }
+        notePeak(injected_peak_depth, injected[CRITICAL].size() + injected[NORMAL].size());
+    }
+    worker_signal.wake();
+}
+
+void JobSystem::WakeSignal::wake() {
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_seq_cst) != 0) epoch.notify_one();
+}
+
+void JobSystem::WakeSignal::wakeAll() {
+    epoch.fetch_add(1, std::memory_order_seq_cst);
+    epoch.notify_all();
+}
+
+void JobSystem::beginHotPhase() {
+    // parked workers get up now, while the caller is still preparing the first jobs
+    if (hot_phases.fetch_add(1, std::memory_order_relaxed) == 0 && idle_policy.frame_aware) worker_signal.wakeAll();
+}
+
+void JobSystem::endHotPhase() { hot_phases.fetch_sub(1, std::memory_order_relaxed); }
+
+bool JobSystem::inHotPhase() const {
+    if (hot_phases.load(std::memory_order_relaxed) == 0) return false;
+    // background workers and threads outside the job system don't take part in the frame
+    return isMainThread() || (tls_thread_index != 0 && !tls_background_worker);
+}
+
+void JobSystem::runJob(Job &job) {
+    // nested helping runs other jobs inside this one, so the previous priority is restored afterwards
+    const JobPriority outer_priority = tls_job_priority;
+    tls_job_priority = job.priority;
+    ThreadCounters &counters = threadCounters();
+    const bool outermost = tls_job_depth++ == 0;
+    const auto start = outermost ? Clock::now() : Clock::time_point{};
+    try {
+        job.invoke(job);
+    } catch (const std::exception& e) {
+       LOG_ERROR(logger, "JobSystem Exception: {}", e.what());
+    } catch (...) {
+       LOG_ERROR(logger, "JobSystem Unknown Exception");
+    }
+    tls_job_depth--;
+    if (outermost) ThreadCounters::add(counters.busy_ns, elapsedNs(start));
+    ThreadCounters::add(counters.jobs_run, 1);
+    tls_job_priority = outer_priority;
+}
+
+JobPriority JobSystem::currentPriority() { return tls_job_priority; }
+
+void JobSystem::finishJob(Job *job) {
+    job->destroy(*job);
+    const JobHandle counter = std::move(job->counter);
+    freeJob(job);
+
+    bool completed = false;
+    if (counter->pending.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+        completed = true;
+        releaseContinuations(*counter.get());
+    }
+    if (active_jobs.fetch_sub(1, std::memory_order_seq_cst) == 1) completed = true;
+    // a parked helper may be waiting for exactly this; which signal it sleeps on isn't known here
+    if (completed && parked_helpers.load(std::memory_order_seq_cst) != 0) {
+        worker_signal.wakeAll();
+        background_signal.wakeAll();
+    }
+}
+
+void JobSystem::releaseContinuations(JobCounter &counter) {
+    if (!counter.has_continuations.load(std::memory_order_seq_cst)) return;
+
+    std::vector<Job *> ready;
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        jobs.push(std::move(job));
-        active_jobs++;
+        const auto lock = timedLock(counter.mutex);
+        ready.swap(counter.continuations);
+    }
+    for (Job *job : ready) {
+        if (job->unmet_dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) push(job);
     }
-    condition.notify_one();
+
+    // hand the storage back so the pooled counter doesn't allocate next time
+    ready.clear();
+    const auto lock = timedLock(counter.mutex);
+    if (counter.continuations.empty()) counter.continuations.swap(ready);
+}
+
+size_t JobSystem::dedicatedThread(const std::string &name) {
+    init(); // dedicated thread indices follow the workers
+
+    for (size_t i = 0; i < dedicated.size(); i++) {
+        if (dedicated[i]->name == name) return i;
+    }
+
+    const size_t id = dedicated.size();
+    auto &dt = *dedicated.emplace_back(std::make_unique<DedicatedThread>());
+    dt.name = name;
+    const size_t thread_index = workers.size() + background_worker_count + 1 + id;
+    dt.thread = std::thread([this, &dt, thread_index] {
+        setupThread(dt.name, thread_index, {});
+        while (true) {
+            Job *job;
+            {
+                std::unique_lock<std::mutex> lock(dt.mutex);
+                dt.condition.wait(lock, [&dt] { return dt.stop || !dt.jobs.empty(); });
+
+                if (dt.stop && dt.jobs.empty()) return;
+
+                job = dt.jobs.pop();
+            }
+            runJob(*job);
+            finishJob(job);
+        }
+    });
+    LOG_INFO(logger, "JobSystem: dedicated thread [{}] started", name);
+    return id;
+}
+
+bool JobSystem::runOneMainThreadJob() {
+    Job *job;
+    {
+        const auto lock = timedLock(main_mutex);
+        if (main_jobs.empty()) return false;
+        job = main_jobs.pop();
+    }
+    runJob(*job);
+    finishJob(job);
+    return true;
+}
+
+void JobSystem::runMainThreadJobs() {
+    // jobs scheduled on the main thread by these jobs run next frame
+    size_t count;
+    {
+        const auto lock = timedLock(main_mutex);
+        count = main_jobs.count;
+    }
+    for (size_t i = 0; i < count; i++) {
+        runOneMainThreadJob();
+    }
+}
+
+void JobSystem::waitOnMainThread(const JobHandle &handle) {
+    if (!handle) return;
+    helpUntil(handle->pending, true);
 }
 
 void JobSystem::wait() {
-    std::unique_lock<std::mutex> lock(wait_mutex);
-    wait_condition.wait(lock, [this] { 
-        // We need to check if queue is empty AND active_jobs is 0.
-        // Actually active_jobs incremented on push, decremented on finish.
-        // So active_jobs == 0 means queue is empty AND no one is working.
-        return active_jobs == 0; 
+    // active_jobs is incremented on push and decremented on finish,
+    // so 0 means every queue is empty AND no one is working (main thread jobs included)
+    helpUntil(active_jobs, isMainThread());
+}
+
+void JobSystem::wait(const JobHandle &handle) {
+    if (!handle) return;
+    helpUntil(handle->pending);
+}
+
+size_t JobSystem::defaultGrain(size_t range_size) const {
+    // about 8 pieces per thread, enough for stealing to even out uneven pieces
+    return std::max<size_t>(1, range_size / (8 * (workers.size() + 1)));
+}
+
+bool JobSystem::localQueueEmpty() const {
+    // the queue forks of the running job go to
+    const JobPriority priority = tls_job_priority;
+    if (priority == JobPriority::Background) return background.empty();
+    const size_t level = priority == JobPriority::Critical ? CRITICAL : NORMAL;
+    const size_t index = tls_thread_index;
+    if (index >= 1 && index <= workers.size()) return workers[index - 1]->deques[level].empty();
+    return injected[level].empty();
+}
+
+size_t JobSystem::threadIndex() { return tls_thread_index; }
+
+double JobSystemStats::workerUtilization() const {
+    if (interval.count() == 0 || worker_queues.empty()) return 0.0;
+    std::chrono::nanoseconds busy{0};
+    for (const auto &thread : threads) {
+        if (thread.thread_index >= 1 && thread.thread_index <= worker_queues.size()) busy += thread.busy;
+    }
+    return static_cast<double>(busy.count()) / (static_cast<double>(interval.count()) * worker_queues.size());
+}
+
+JobSystemStats JobSystem::collectStats() {
+    JobSystemStats stats;
+    const auto now = Clock::now();
+    stats.interval = std::chrono::duration_cast<std::chrono::nanoseconds>(now - stats_since);
+    stats_since = now;
+
+    CounterRegistry::Get().forEach([&stats](ThreadCounters &counters) {
+        JobThreadStats total;
+        total.busy = std::chrono::nanoseconds{counters.busy_ns.load(std::memory_order_relaxed)};
+        total.idle = std::chrono::nanoseconds{counters.idle_ns.load(std::memory_order_relaxed)};
+        total.lock_wait = std::chrono::nanoseconds{counters.lock_wait_ns.load(std::memory_order_relaxed)};
+        total.jobs_run = counters.jobs_run.load(std::memory_order_relaxed);
+        total.jobs_stolen = counters.jobs_stolen.load(std::memory_order_relaxed);
+
+        auto &thread = stats.threads.emplace_back();
+        thread.name = counters.name;
+        thread.thread_index = counters.thread_index;
+        thread.busy = total.busy - counters.reported.busy;
+        thread.idle = total.idle - counters.reported.idle;
+        thread.lock_wait = total.lock_wait - counters.reported.lock_wait;
+        thread.jobs_run = total.jobs_run - counters.reported.jobs_run;
+        thread.jobs_stolen = total.jobs_stolen - counters.reported.jobs_stolen;
+        counters.reported = total;
     });
+
+    const auto depth = [](size_t current, std::atomic<size_t> &peak) {
+        return JobQueueDepth{current, std::max(current, peak.exchange(0, std::memory_order_relaxed))};
+    };
+    for (auto &worker : workers) {
+        stats.worker_queues.push_back(
+            depth(worker->deques[CRITICAL].size() + worker->deques[NORMAL].size(), worker->peak_depth));
+    }
+    stats.injected = depth(injected[CRITICAL].size() + injected[NORMAL].size(), injected_peak_depth);
+    stats.background = depth(background.size(), background_peak_depth);
+    {
+        const auto lock = timedLock(main_mutex);
+        stats.main_thread_jobs = main_jobs.count;
+    }
+    return stats;
+}
+
+void JobSystem::profileStats() {
+    const auto stats = collectStats();
+    const auto us = [](std::chrono::nanoseconds ns) { return ns.count() / 1000.0; };
+
+    TimeProfilerCounter("JobSystem/worker_utilization", stats.workerUtilization());
+    for (const auto &thread : stats.threads) {
+        // threads of a previous init(), or which did nothing since the last frame
+        if (thread.jobs_run == 0 && thread.idle.count() == 0 && thread.lock_wait.count() == 0) continue;
+        auto it = thread_counter_names.find(thread.name);
+        if (it == thread_counter_names.end()) {
+            const std::string prefix = "JobSystem/" + thread.name + "/";
+            it = thread_counter_names
+                     .emplace(thread.name, ThreadCounterNames{prefix + "busy_us", prefix + "idle_us",
+                                                              prefix + "lock_wait_us", prefix + "jobs_run",
+                                                              prefix + "jobs_stolen"})
+                     .first;
+        }
+        const auto &names = it->second;
+        TimeProfilerCounter(names.busy, us(thread.busy));
+        TimeProfilerCounter(names.idle, us(thread.idle));
+        TimeProfilerCounter(names.lock_wait, us(thread.lock_wait));
+        TimeProfilerCounter(names.jobs_run, static_cast<double>(thread.jobs_run));
+        TimeProfilerCounter(names.jobs_stolen, static_cast<double>(thread.jobs_stolen));
+    }
+    for (size_t i = queue_counter_names.size(); i < stats.worker_queues.size(); i++) {
+        const std::string prefix = "JobSystem/job-worker-" + std::to_string(i) + "/";
+        queue_counter_names.push_back({prefix + "queue_depth", prefix + "queue_peak"});
+    }
+    for (size_t i = 0; i < stats.worker_queues.size(); i++) {
+        TimeProfilerCounter(queue_counter_names[i].depth, static_cast<double>(stats.worker_queues[i].current));
+        TimeProfilerCounter(queue_counter_names[i].peak, static_cast<double>(stats.worker_queues[i].peak));
+    }
+    TimeProfilerCounter("JobSystem/injected/queue_depth", static_cast<double>(stats.injected.current));
+    TimeProfilerCounter("JobSystem/injected/queue_peak", static_cast<double>(stats.injected.peak));
+    TimeProfilerCounter("JobSystem/background/queue_depth", static_cast<double>(stats.background.current));
+    TimeProfilerCounter("JobSystem/background/queue_peak", static_cast<double>(stats.background.peak));
+    TimeProfilerCounter("JobSystem/main_thread/queue_depth", static_cast<double>(stats.main_thread_jobs));
 }
 
 void JobSystem::cleanup() {
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        stop = true;
+    stop.store(true, std::memory_order_seq_cst);
+    worker_signal.wakeAll();
+    background_signal.wakeAll();
+    for (auto &worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
     }
-    condition.notify_all();
-    for (std::thread& worker : workers) {
+    workers.clear();
+    for (auto &worker : background_workers) {
         if (worker.joinable()) worker.join();
     }
-    workers.clear();
-    stop = false;
+    background_workers.clear();
+    background_worker_count = 0;
+
+    for (auto &dt : dedicated) {
+        {
+            std::unique_lock<std::mutex> lock(dt->mutex);
+            dt->stop = true;
+        }
+        dt->condition.notify_all();
+        if (dt->thread.joinable()) dt->thread.join();
+    }
+    dedicated.clear();
+    stop.store(false, std::memory_order_relaxed);
 }
 
 } // namespace Pelican
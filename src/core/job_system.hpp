@@ -2,15 +2,142 @@
 
 #include <vector>
 #include <thread>
-#include <queue>
 #include <functional>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include "job_queue.hpp"
 #include "log.hpp"
 
 namespace Pelican {
 
+class JobSystem;
+class JobCounter;
+
+enum class JobPriority {
+    Critical,   // frame critical (ECS systems); always picked first
+    Normal,
+    Background, // long running work (asset decoding, compression); only run by background workers
+};
+
+// Reference to a pooled JobCounter (intrusive reference count, no allocation in steady state)
+class JobHandle {
+public:
+    JobHandle() = default;
+    JobHandle(const JobHandle &other) : counter{other.counter} { addRef(); }
+    JobHandle(JobHandle &&other) noexcept : counter{std::exchange(other.counter, nullptr)} {}
+    JobHandle &operator=(JobHandle other) noexcept {
+        std::swap(counter, other.counter);
+        return *this;
+    }
+    ~JobHandle() { release(); }
+
+    // A new counter with nothing scheduled into it yet
+    static JobHandle create();
+
+    JobCounter *operator->() const { return counter; }
+    JobCounter *get() const { return counter; }
+    explicit operator bool() const { return counter != nullptr; }
+    bool operator==(const JobHandle &other) const { return counter == other.counter; }
+
+private:
+    explicit JobHandle(JobCounter *_counter) : counter{_counter} {}
+    void addRef();
+    void release();
+
+    JobCounter *counter = nullptr;
+};
+
+// Completion counter of a job, or of a group of jobs added with JobSystem::scheduleInto().
+// It reaches zero when every job added to it has finished; jobs depending on it are started then.
+class JobCounter {
+public:
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    friend class JobHandle;
+    struct Job;
+
+    bool addContinuation(Job *job);
+
+    std::atomic<int> refs{0};
+    std::atomic<int> pending{0};
+    std::atomic<bool> has_continuations{false};
+    std::mutex mutex; // guards continuations, only taken when a job depends on this counter
+    std::vector<Job *> continuations; // keeps its capacity while the counter is pooled
+    JobCounter *pool_next = nullptr;
+};
+// Placement of worker threads on CPUs
+enum class JobThreadPinning {
+    None,          // left to the OS scheduler
+    PhysicalCores, // one worker per physical performance core; SMT siblings and efficiency cores stay free
+    CpuList,       // workers take the logical CPUs of JobSystemConfig::cpus, in order
+};
+
+// How long an idle thread keeps looking for work before it sleeps and has to be woken (a futex wake-up
+// costs several microseconds)
+struct JobIdlePolicy {
+    std::chrono::microseconds spin{20};   // polling with pause instructions in between
+    std::chrono::microseconds yield{200}; // then polling with a yield in between
+    // between beginHotPhase() and endHotPhase() (ECS update) idle workers never sleep,
+    // so each dependency level starts without wake-up latency
+    bool frame_aware = true;
+};
+
+struct JobSystemConfig {
+    int worker_count = 0;             // 0 = auto (one per core, or per listed CPU when pinned)
+    int background_worker_count = -1; // -1 = auto (one); never less than one
+    JobThreadPinning pinning = JobThreadPinning::None;
+    std::vector<int> cpus; // CpuList only
+    JobIdlePolicy idle;
+};
+
+// Counters of one thread over a JobSystem::collectStats() interval.
+// A busy or idle span is counted in the interval it ends in.
+struct JobThreadStats {
+    std::string name;
+    size_t thread_index = 0;
+    std::chrono::nanoseconds busy{0};      // running jobs (jobs run while helping inside a job count once)
+    std::chrono::nanoseconds idle{0};      // looking for work: spinning, yielding or parked
+    std::chrono::nanoseconds lock_wait{0}; // blocked on a contended job system lock
+    uint64_t jobs_run = 0;
+    uint64_t jobs_stolen = 0;
+};
+
+// Depth of a queue when the stats were collected, and its (approximate) peak since the previous collection
+struct JobQueueDepth {
+    size_t current = 0;
+    size_t peak = 0;
+};
+
+struct JobSystemStats {
+    std::chrono::nanoseconds interval{0};
+    std::vector<JobThreadStats> threads;      // every thread that has used the job system
+    std::vector<JobQueueDepth> worker_queues; // both deques of each worker
+    JobQueueDepth injected;
+    JobQueueDepth background;
+    size_t main_thread_jobs = 0;
+
+    // Busy share of the workers over the interval, 0 to 1
+    double workerUtilization() const;
+};
+
+// Work-stealing job system.
+// Each worker owns a Chase-Lev deque per priority: jobs scheduled from a worker go to its own deque, jobs
+// scheduled from any other thread go to a lock-free injection queue. Idle workers steal from each other and
+// finally park on an atomic wake counter, so neither scheduling nor completion takes a lock.
+// Background jobs have their own queue and workers, so they never delay a frame.
 class JobSystem {
 public:
     static JobSystem& Get() {
@@ -18,32 +145,375 @@ public:
         return instance;
     }
 
-    // Initialize with thread count (0 = auto)
-    void init(int thread_count = 0);
-    
-    // Schedule a job
-    void schedule(std::function<void()> job);
+    // Thread a job is bound to: any worker, the main thread, or an index returned by dedicatedThread()
+    static constexpr size_t ANY_WORKER = static_cast<size_t>(-1);
+    static constexpr size_t MAIN_THREAD = static_cast<size_t>(-2);
+
+    // Initialize with worker and background worker counts (0 / -1 = auto).
+    // The calling thread becomes the main thread.
+    void init(int thread_count = 0, int background_thread_count = -1);
+    // Same with CPU pinning; workers are named "job-worker-N" / "job-bg-N" for profilers and top
+    void init(const JobSystemConfig &config);
     
-    // Wait for all currently scheduled jobs to complete
+    // Schedule a job (any callable); it starts once every dependency has completed.
+    // Captures up to Job::INLINE_SIZE bytes are stored in the pooled job record without allocating.
+    template <class F>
+    JobHandle schedule(F &&job, std::span<const JobHandle> dependencies = {},
+                       JobPriority priority = JobPriority::Normal);
+
+    // Schedule a job as part of an existing counter, e.g. children extending the subgraph of their parent.
+    // The counter must not be one of the dependencies. priority only applies to ANY_WORKER jobs.
+    template <class F>
+    void scheduleInto(const JobHandle &counter, F &&job, std::span<const JobHandle> dependencies = {},
+                      size_t thread = ANY_WORKER, JobPriority priority = JobPriority::Normal);
+
+    // Priority of the job running on the calling thread (Critical outside of jobs)
+    static JobPriority currentPriority();
+
+    // Wait for all currently scheduled jobs to complete.
+    // The calling thread runs pending jobs meanwhile instead of sleeping.
     void wait();
 
+    // Runs one queued job on the calling thread if there is one, as wait() does while waiting
+    bool runPendingJob();
+
+    // Wait only for the jobs of one counter (and whatever was scheduled into it meanwhile).
+    // Also runs pending jobs, which may belong to other counters.
+    void wait(const JobHandle &handle);
+
+    // Frame aware idle policy: wakes every worker and keeps it polling until the matching endHotPhase().
+    // Phases may nest; idle behaviour only changes with JobIdlePolicy::frame_aware.
+    void beginHotPhase();
+    void endHotPhase();
+    // True on a thread running frame work (main thread, workers, dedicated threads) during a hot phase,
+    // where blocking on I/O stalls the frame
+    bool inHotPhase() const;
+
     // Cleanup (join threads)
     void cleanup();
 
+    // Calls fn(sub_begin, sub_end) over [begin, end) in parallel and returns when the whole range is done.
+    // The range is split recursively, and only while other threads are looking for work, so uneven
+    // iterations balance themselves. grain is the smallest piece handed out; 0 picks one from the range size.
+    // If a piece throws, the call still waits for every forked piece and then rethrows the first exception.
+    template <class F> void parallelFor(size_t begin, size_t end, size_t grain, F &&fn);
+
+    // Folds map(sub_begin, sub_end) results of sub-ranges with reduce(T, T) -> T, starting from identity.
+    // reduce must be associative and commutative; the grouping of sub-ranges is not deterministic.
+    // Exceptions are rethrown like in parallelFor.
+    template <class T, class FMap, class FReduce>
+    T parallelReduce(size_t begin, size_t end, size_t grain, T identity, FMap &&map, FReduce &&reduce);
+
+    // Get (or start) a named thread which runs only jobs scheduled to it
+    size_t dedicatedThread(const std::string &name);
+
+    // Schedule a job on a dedicated thread (or MAIN_THREAD); wait() also waits for it
+    template <class F>
+    JobHandle scheduleOn(size_t dedicated_thread, F &&job, std::span<const JobHandle> dependencies = {});
+
+    // Runs the jobs scheduled on MAIN_THREAD so far. Called once per frame by the main loop,
+    // outside of ECS update so main thread jobs may touch the world.
+    void runMainThreadJobs();
+
+    // Main thread only: like wait(handle), but also runs main thread jobs, which the handle may depend on.
+    // Not for use inside ECS update.
+    void waitOnMainThread(const JobHandle &handle);
+
+    bool isMainThread() const { return std::this_thread::get_id() == main_thread; }
+
+    // Index of the calling thread: 0 for non-worker threads (main), 1..N for workers,
+    // then background workers, then dedicated threads
+    static size_t threadIndex();
+
+    // Number of distinct values threadIndex() can return (workers + background + dedicated + main)
+    size_t threadSlotCount() const { return workers.size() + background_worker_count + dedicated.size() + 1; }
+
+    // Counters since the previous call (or init), e.g. once per frame; call from one thread only
+    JobSystemStats collectStats();
+    // collectStats() sent to the profiler as counters, per thread and per queue; same thread as collectStats()
+    void profileStats();
+
+    size_t workerCount() const { return workers.size(); }
+    size_t backgroundWorkerCount() const { return background_worker_count; }
+
     ~JobSystem();
 
 private:
     JobSystem() = default;
 
-    std::vector<std::thread> workers;
-    std::queue<std::function<void()>> jobs;
-    std::mutex queue_mutex;
-    std::condition_variable condition;
-    
-    bool stop = false;
-    std::atomic<int> active_jobs{0};
-    std::mutex wait_mutex;
-    std::condition_variable wait_condition;
+    using Job = JobCounter::Job;
+
+    // deque / injection queue level of Critical and Normal jobs
+    static constexpr size_t CRITICAL = 0;
+    static constexpr size_t NORMAL = 1;
+
+    struct alignas(64) Worker {
+        std::thread thread;
+        WorkStealingDeque<Job> deques[2];
+        std::atomic<size_t> peak_depth{0};
+    };
+
+    // idle threads park on epoch; schedulers bump it and notify only when someone sleeps
+    struct WakeSignal {
+        alignas(64) std::atomic<uint32_t> epoch{0};
+        alignas(64) std::atomic<uint32_t> sleeping{0};
+
+        void wake();
+        void wakeAll();
+    };
+
+    friend class JobHandle;
+    static Job *allocJob();
+    static void freeJob(Job *job);
+    static JobCounter *allocCounter();
+    static void freeCounter(JobCounter *counter);
+
+    template <class FFind> void runLoop(WakeSignal &signal, bool frame_worker, FFind &&find);
+    bool hotPhase() const { return idle_policy.frame_aware && hot_phases.load(std::memory_order_relaxed) != 0; }
+    void workerLoop(size_t worker);
+    void backgroundWorkerLoop(size_t thread_index);
+    Job *findJob(size_t worker);
+    Job *stealJob(size_t thief, size_t level);
+    Job *findJobToHelp();
+    void helpUntil(const std::atomic<int> &remaining_jobs, bool run_main_jobs = false);
+    bool runOneMainThreadJob();
+    void submit(Job *job, std::span<const JobHandle> dependencies);
+    void push(Job *job);
+    void runJob(Job &job);
+    void finishJob(Job *job);
+    void releaseContinuations(JobCounter &counter);
+
+    size_t defaultGrain(size_t range_size) const;
+    bool localQueueEmpty() const;
+    template <class FPiece, class FFork>
+    void splitRange(size_t begin, size_t end, size_t grain, FPiece &&piece, FFork &&fork);
+
+    // First exception thrown by the pieces of a parallel loop; rethrown by the caller once every fork is done
+    struct FirstException {
+        std::mutex mutex;
+        std::exception_ptr exception;
+
+        void capture() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!exception) exception = std::current_exception();
+        }
+        void rethrow() const {
+            if (exception) std::rethrow_exception(exception);
+        }
+    };
+
+    // FIFO of jobs linked through Job::next, so queueing never allocates
+    struct JobList {
+        Job *head = nullptr;
+        Job *tail = nullptr;
+        size_t count = 0;
+
+        void push(Job *job);
+        Job *pop();
+        bool empty() const { return head == nullptr; }
+    };
+
+    struct DedicatedThread {
+        std::string name;
+        std::thread thread;
+        JobList jobs;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stop = false;
+    };
+    std::vector<std::unique_ptr<DedicatedThread>> dedicated;
+
+    std::thread::id main_thread;
+    JobList main_jobs;
+    std::mutex main_mutex;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    InjectionQueue<Job> injected[2];
+    std::atomic<size_t> injected_peak_depth{0};
+    alignas(64) std::atomic<int64_t> critical_queued{0}; // lets workers skip the critical scan
+    WakeSignal worker_signal;
+
+    std::vector<std::thread> background_workers;
+    size_t background_worker_count = 0;
+    InjectionQueue<Job> background;
+    std::atomic<size_t> background_peak_depth{0};
+    WakeSignal background_signal;
+
+    std::chrono::steady_clock::time_point stats_since;
+    // profiler counter names, built on first use instead of every frame
+    struct ThreadCounterNames {
+        std::string busy, idle, lock_wait, jobs_run, jobs_stolen;
+    };
+    struct QueueCounterNames {
+        std::string depth, peak;
+    };
+    std::unordered_map<std::string, ThreadCounterNames> thread_counter_names; // by thread name
+    std::vector<QueueCounterNames> queue_counter_names;                      // by worker
+
+    JobIdlePolicy idle_policy;
+    std::atomic<int> hot_phases{0};
+
+    std::atomic<bool> stop{false};
+    alignas(64) std::atomic<int> active_jobs{0};
+    // threads parked in helpUntil(); they sleep on a queue signal, so finished counters bump it too
+    std::atomic<int> parked_helpers{0};
+};
+
+// beginHotPhase() for the lifetime of the object, so an exception can't leave the workers polling
+class JobHotPhaseScope {
+public:
+    JobHotPhaseScope() { JobSystem::Get().beginHotPhase(); }
+    ~JobHotPhaseScope() { JobSystem::Get().endHotPhase(); }
+    JobHotPhaseScope(const JobHotPhaseScope &) = delete;
+    JobHotPhaseScope &operator=(const JobHotPhaseScope &) = delete;
+};
+
+inline JobHandle JobHandle::create() { return JobHandle{JobSystem::allocCounter()}; }
+inline void JobHandle::addRef() {
+    if (counter) counter->refs.fetch_add(1, std::memory_order_relaxed);
+}
+inline void JobHandle::release() {
+    if (counter && counter->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) JobSystem::freeCounter(counter);
+    counter = nullptr;
+}
+
+// Pooled job record; the callable lives inline unless its captures are too large
+struct JobCounter::Job {
+    static constexpr size_t INLINE_SIZE = 64;
+
+    alignas(std::max_align_t) unsigned char storage[INLINE_SIZE];
+    void (*invoke)(Job &) = nullptr;
+    void (*destroy)(Job &) = nullptr;
+    JobHandle counter;
+    size_t thread = JobSystem::ANY_WORKER;
+    JobPriority priority = JobPriority::Normal;
+    std::atomic<int> unmet_dependencies{0};
+    Job *next = nullptr; // freelist / JobList link
+
+    template <class F> void setFunc(F &&func) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= INLINE_SIZE && alignof(Fn) <= alignof(std::max_align_t)) {
+            new (storage) Fn(std::forward<F>(func));
+            invoke = [](Job &job) { (*std::launder(reinterpret_cast<Fn *>(job.storage)))(); };
+            destroy = [](Job &job) { std::launder(reinterpret_cast<Fn *>(job.storage))->~Fn(); };
+        } else {
+            Fn *heap = new Fn(std::forward<F>(func));
+            std::memcpy(storage, &heap, sizeof(heap));
+            invoke = [](Job &job) { (*heapFunc<Fn>(job))(); };
+            destroy = [](Job &job) { delete heapFunc<Fn>(job); };
+        }
+    }
+
+    template <class Fn> static Fn *heapFunc(Job &job) {
+        Fn *heap;
+        std::memcpy(&heap, job.storage, sizeof(heap));
+        return heap;
+    }
 };
 
+template <class F>
+JobHandle JobSystem::schedule(F &&job, std::span<const JobHandle> dependencies, JobPriority priority) {
+    auto counter = JobHandle::create();
+    scheduleInto(counter, std::forward<F>(job), dependencies, ANY_WORKER, priority);
+    return counter;
+}
+
+template <class F>
+void JobSystem::scheduleInto(const JobHandle &counter, F &&job, std::span<const JobHandle> dependencies,
+                             size_t thread, JobPriority priority) {
+    Job *record = allocJob();
+    record->setFunc(std::forward<F>(job));
+    record->counter = counter;
+    record->thread = thread;
+    record->priority = priority;
+    submit(record, dependencies);
+}
+
+template <class F>
+JobHandle JobSystem::scheduleOn(size_t dedicated_thread, F &&job, std::span<const JobHandle> dependencies) {
+    auto counter = JobHandle::create();
+    scheduleInto(counter, std::forward<F>(job), dependencies, dedicated_thread);
+    return counter;
+}
+
+template <class FPiece, class FFork>
+void JobSystem::splitRange(size_t begin, size_t end, size_t grain, FPiece &&piece, FFork &&fork) {
+    while (end - begin > grain) {
+        // an empty local queue means the half handed out last time was stolen: hand out another one
+        if (localQueueEmpty()) {
+            const size_t mid = begin + (end - begin) / 2;
+            fork(mid, end);
+            end = mid;
+        } else {
+            piece(begin, begin + grain);
+            begin += grain;
+        }
+    }
+    piece(begin, end);
+}
+
+template <class F> void JobSystem::parallelFor(size_t begin, size_t end, size_t grain, F &&fn) {
+    if (begin >= end) return;
+    if (grain == 0) grain = defaultGrain(end - begin);
+    if (workers.empty() || end - begin <= grain) {
+        fn(begin, end);
+        return;
+    }
+
+    const auto counter = JobHandle::create();
+    const JobPriority priority = currentPriority(); // forks inherit the priority of the caller
+    FirstException error;
+    // self-referencing lambda instead of std::function, so forked jobs capture 24 bytes and stay inline
+    const auto run = [&](const auto &self, size_t run_begin, size_t run_end) -> void {
+        try {
+            splitRange(run_begin, run_end, grain, fn, [&](size_t fork_begin, size_t fork_end) {
+                scheduleInto(counter, [&self, fork_begin, fork_end] { self(self, fork_begin, fork_end); }, {},
+                             ANY_WORKER, priority);
+            });
+        } catch (...) {
+            error.capture();
+        }
+    };
+    // forks refer to this frame, so it is left only after all of them finished
+    run(run, begin, end);
+    wait(counter);
+    error.rethrow();
+}
+
+template <class T, class FMap, class FReduce>
+T JobSystem::parallelReduce(size_t begin, size_t end, size_t grain, T identity, FMap &&map, FReduce &&reduce) {
+    if (begin >= end) return identity;
+    if (grain == 0) grain = defaultGrain(end - begin);
+    if (workers.empty() || end - begin <= grain) return reduce(std::move(identity), map(begin, end));
+
+    // one partial per job, merged under a lock: there are only O(threads * log(range)) jobs
+    T result = identity;
+    std::mutex result_mutex;
+    const auto counter = JobHandle::create();
+    const JobPriority priority = currentPriority();
+    FirstException error;
+    const auto run = [&](const auto &self, size_t run_begin, size_t run_end) -> void {
+        try {
+            T partial = identity;
+            splitRange(
+                run_begin, run_end, grain,
+                [&](size_t piece_begin, size_t piece_end) {
+                    partial = reduce(std::move(partial), map(piece_begin, piece_end));
+                },
+                [&](size_t fork_begin, size_t fork_end) {
+                    scheduleInto(counter, [&self, fork_begin, fork_end] { self(self, fork_begin, fork_end); }, {},
+                                 ANY_WORKER, priority);
+                });
+            std::lock_guard<std::mutex> lock(result_mutex);
+            result = reduce(std::move(result), std::move(partial));
+        } catch (...) {
+            error.capture();
+        }
+    };
+    run(run, begin, end);
+    wait(counter);
+    error.rethrow();
+    return result;
+}
+
 } // namespace Pelican
@@ -0,0 +1,24 @@
+#include "job_task.hpp"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace Pelican {
+
+void ReadFileAwaiter::read() {
+    try {
+        std::error_code ec;
+        const auto sz = std::filesystem::file_size(path, ec);
+        std::ifstream f{path, std::ios_base::binary};
+        if (ec || !f)
+            throw std::runtime_error("failed to open file : " + path);
+        bytes.resize(sz);
+        f.read(reinterpret_cast<char *>(bytes.data()), sz);
+        if (!f)
+            throw std::runtime_error("failed to read file : " + path);
+    } catch (...) {
+        exception = std::current_exception();
+    }
+}
+
+} // namespace Pelican
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <cassert>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "job_system.hpp"
+
+namespace Pelican {
+
+// Coroutines on top of JobSystem.
+//
+//   Task<Model> loadModel(std::string path) {
+//       auto bytes = co_await readFileAsync(path);      // read by a background job, this thread is free
+//       auto textures = co_await decodeTextures(bytes); // child task, runs inline
+//       co_await switchToMain();                         // continues in JobSystem::runMainThreadJobs()
+//       registerMaterials(textures);
+//       co_return model;
+//   }
+//
+// A suspended task holds no thread; its frame waits as a job continuation. Every resumption is scheduled
+// into the counter of the outermost task, so the handle returned by start() completes exactly when the
+// whole chain has finished.
+
+template <class T = void> class Task;
+
+namespace internal {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    JobHandle counter;
+    JobPriority priority = JobPriority::Normal;
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <class TPromise> std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> h) noexcept {
+            // symmetric transfer back to the awaiting task, on whichever thread finished this one
+            if (auto continuation = h.promise().continuation) return continuation;
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+    void rethrowIfFailed() {
+        if (exception) std::rethrow_exception(exception);
+    }
+};
+
+template <class T> struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    template <class U> void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+    T result() {
+        rethrowIfFailed();
+        return std::move(*value);
+    }
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() { rethrowIfFailed(); }
+};
+
+// Resumes h as a job of its task's counter once the dependencies have completed
+template <class TPromise>
+void resumeAsJob(std::coroutine_handle<TPromise> h, std::span<const JobHandle> dependencies = {},
+                 size_t thread = JobSystem::ANY_WORKER) {
+    JobSystem::Get().scheduleInto(h.promise().counter, [h] { h.resume(); }, dependencies, thread,
+                                  h.promise().priority);
+}
+
+} // namespace internal
+
+// Lazily started coroutine. Either co_await it from another task (it then runs inline on the same
+// thread), or start() it on a worker; the Task object must stay alive until it has finished.
+template <class T> class Task {
+  public:
+    using promise_type = internal::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> _handle) : handle{_handle} {}
+    Task(Task &&other) noexcept : handle{std::exchange(other.handle, nullptr)} {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    struct Awaiter {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() noexcept { return false; }
+        template <class TPromise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<TPromise> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            handle.promise().counter = awaiting.promise().counter;
+            handle.promise().priority = awaiting.promise().priority;
+            return handle;
+        }
+        T await_resume() { return handle.promise().result(); }
+    };
+    Awaiter operator co_await() && noexcept { return Awaiter{handle}; }
+
+    // Starts the task on a worker; the returned handle completes when the task has finished.
+    // Every resumption of the task (and of the tasks it awaits) is scheduled with this priority.
+    JobHandle start(JobPriority priority = JobPriority::Normal) {
+        handle.promise().counter = JobHandle::create();
+        handle.promise().priority = priority;
+        internal::resumeAsJob(handle);
+        return handle.promise().counter;
+    }
+
+    bool done() const { return handle.done(); }
+
+    // Result of a finished task (rethrows its exception)
+    T result() { return handle.promise().result(); }
+
+    // Starts the task and blocks until it has finished, running jobs meanwhile.
+    // For loading code outside the frame only: during ECS update (systems, frame jobs) a task waiting on
+    // file I/O would stall the whole frame, so co_await it from a task or start() it and check done().
+    T get() {
+        auto &js = JobSystem::Get();
+        assert(!js.inHotPhase() && "Task::get() blocks the frame; co_await or start() the task instead");
+        const auto counter = start(JobSystem::currentPriority());
+        if (js.isMainThread())
+            js.waitOnMainThread(counter);
+        else
+            js.wait(counter);
+        return result();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <class T> Task<T> internal::TaskPromise<T>::get_return_object() {
+    return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+inline Task<void> internal::TaskPromise<void>::get_return_object() {
+    return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+namespace internal {
+
+struct JobAwaiter {
+    JobHandle handle;
+
+    bool await_ready() noexcept { return !handle || handle->done(); }
+    template <class TPromise> void await_suspend(std::coroutine_handle<TPromise> h) {
+        const JobHandle dependencies[] = {handle};
+        resumeAsJob(h, dependencies);
+    }
+    void await_resume() noexcept {}
+};
+
+struct SwitchThreadAwaiter {
+    size_t thread;
+
+    bool await_ready() noexcept { return false; }
+    template <class TPromise> void await_suspend(std::coroutine_handle<TPromise> h) { resumeAsJob(h, {}, thread); }
+    void await_resume() noexcept {}
+};
+
+} // namespace internal
+
+// co_await handle: suspends until the job (or group) has completed, then continues on a worker
+inline internal::JobAwaiter operator co_await(JobHandle handle) noexcept { return {std::move(handle)}; }
+
+// co_await switchToMain(): continues in the next JobSystem::runMainThreadJobs() on the main thread
+inline internal::SwitchThreadAwaiter switchToMain() noexcept { return {JobSystem::MAIN_THREAD}; }
+
+// co_await switchToWorker(): continues on a worker, e.g. after the main thread part of a task
+inline internal::SwitchThreadAwaiter switchToWorker() noexcept { return {JobSystem::ANY_WORKER}; }
+
+// co_await readFileAsync(path): whole file contents, read by a background job; the task then continues
+// with its own priority.
+// The read itself is a plain blocking std::ifstream read, so it occupies a background worker until the file
+// is in memory (there are few of them, one by default): concurrent reads of large files queue behind each
+// other. The task's thread is free meanwhile, but no OS asynchronous I/O is involved.
+// Throws std::runtime_error from the co_await when the file can't be read.
+class ReadFileAwaiter {
+    std::string path;
+    std::vector<uint8_t> bytes;
+    std::exception_ptr exception;
+
+    void read();
+
+  public:
+    explicit ReadFileAwaiter(std::string _path) : path{std::move(_path)} {}
+
+    bool await_ready() noexcept { return false; }
+    template <class TPromise> void await_suspend(std::coroutine_handle<TPromise> h) {
+        JobSystem::Get().scheduleInto(
+            h.promise().counter,
+            [this, h] {
+                read();
+                internal::resumeAsJob(h);
+            },
+            {}, JobSystem::ANY_WORKER, JobPriority::Background);
+    }
+    std::vector<uint8_t> await_resume() {
+        if (exception) std::rethrow_exception(exception);
+        return std::move(bytes);
+    }
+};
+
+inline ReadFileAwaiter readFileAsync(std::string path) { return ReadFileAwaiter{std::move(path)}; }
+
+} // namespace Pelican
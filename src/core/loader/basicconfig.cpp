@@ -95,6 +95,29 @@ ProjectBasicConfig::ProjectBasicConfig() {
         asset_data_json = loaded_data;
     }
 
+    job_system_config.worker_count = loader.getVal("basic_config/job_system/workers");
+    job_system_config.background_worker_count = loader.getVal("basic_config/job_system/background_workers");
+    {
+        // "none", "physical_cores", or a list of logical CPUs for the workers
+        const auto pinning = loader.getVal("basic_config/job_system/pinning");
+        if (pinning.is_array()) {
+            job_system_config.pinning = JobThreadPinning::CpuList;
+            job_system_config.cpus = pinning.get<std::vector<int>>();
+        } else if (pinning == "physical_cores") {
+            job_system_config.pinning = JobThreadPinning::PhysicalCores;
+        } else if (pinning == "none") {
+            job_system_config.pinning = JobThreadPinning::None;
+        } else {
+            throw std::runtime_error("unknown job_system/pinning : " + pinning.dump());
+        }
+    }
+
+    const int idle_spin_us = loader.getVal("basic_config/job_system/idle/spin_us");
+    const int idle_yield_us = loader.getVal("basic_config/job_system/idle/yield_us");
+    job_system_config.idle.spin = std::chrono::microseconds{idle_spin_us};
+    job_system_config.idle.yield = std::chrono::microseconds{idle_yield_us};
+    job_system_config.idle.frame_aware = loader.getVal("basic_config/job_system/idle/frame_aware");
+
     LOG_INFO(logger, "project basic config loaded");
 }
 
@@ -110,4 +133,6 @@ std::string ProjectBasicConfig::defaultSceneId() const { return default_scene_id
 std::string ProjectBasicConfig::sceneDataJson() const { return scene_data_json; }
 std::string ProjectBasicConfig::assetDataJson() const { return asset_data_json; }
 
+JobSystemConfig ProjectBasicConfig::jobSystemConfig() const { return job_system_config; }
+
 } // namespace Pelican
@@ -1,4 +1,5 @@
 #include "../container.hpp"
+#include "../job_system.hpp"
 
 #include <glm/glm.hpp>
 #include <string>
@@ -26,6 +27,8 @@ DECLARE_MODULE(ProjectBasicConfig) {
     std::string scene_data_json;
     std::string asset_data_json;
 
+    JobSystemConfig job_system_config;
+
   public:
     ProjectBasicConfig();
 
@@ -39,6 +42,8 @@ DECLARE_MODULE(ProjectBasicConfig) {
     std::string defaultSceneId() const;
     std::string sceneDataJson() const;
     std::string assetDataJson() const;
+
+    JobSystemConfig jobSystemConfig() const;
 };
 
 } // namespace Pelican
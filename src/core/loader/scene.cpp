@@ -5,7 +5,9 @@
 #include "../renderer/camera.hpp"
 
 #include "../ecs/componentinfo.hpp"
+#include "../log.hpp"
 #include "basicconfig.hpp"
+#include <filesystem>
 #include <nlohmann/json.hpp>
 
 #include <components/localtransform.hpp>
@@ -21,25 +23,87 @@ void SceneLoader::load(SceneId scene_id) {
 
     // load from json
     const auto scene_data = nlohmann::json::parse(config.sceneDataJson()).at(scene_id);
+
+    // a prebuilt world image replaces the object list (delete it after editing the scene)
+    std::string world_image;
+    if (scene_data.contains("world_image")) {
+        world_image = scene_data.at("world_image");
+        if (std::filesystem::exists(world_image)) {
+            LOG_INFO(logger, "loading world image \"{}\"", world_image);
+            ecs.loadWorldImage(world_image);
+            return;
+        }
+    }
+
     const auto &objects = scene_data.at("objects");
+    auto &mgr = GET_MODULE(ComponentInfoManager);
 
-    for (const auto &object : objects) {
-        const auto &components_json = object.at("components");
+    struct ObjectDesc {
+        const nlohmann::json *components_json;
         std::vector<ComponentId> components_id;
-        components_id.reserve(components_json.size());
-        for (const auto &component : components_json) {
+        // shared values select the chunk, so they are loaded before allocation
+        std::vector<std::vector<uint8_t>> shared_buffers;
+    };
+    std::vector<ObjectDesc> descs;
+    descs.reserve(objects.size());
+    for (const auto &object : objects) {
+        auto &desc = descs.emplace_back();
+        desc.components_json = &object.at("components");
+        desc.components_id.reserve(desc.components_json->size());
+        desc.shared_buffers.resize(desc.components_json->size());
+        for (int i = 0; const auto &component : *desc.components_json) {
             const std::string name = component.at("name");
-            components_id.push_back(GET_MODULE(ComponentInfoManager).getComponentIdByName(name.c_str()));
+            desc.components_id.push_back(mgr.getComponentIdByName(name.c_str()));
+            const auto index = mgr.getIndexFromComponentId(desc.components_id[i]);
+            if (mgr.getStorageFromIndex(index) == ComponentStorage::Shared) {
+                desc.shared_buffers[i].resize(mgr.getSizeFromIndex(index));
+                mgr.loadByJson(desc.shared_buffers[i].data(), component);
+            }
+            i++;
+        }
+    }
+
+    // consecutive objects with the same components (and shared values) are spawned together,
+    // so allocation and init() run once per batch instead of once per object
+    for (size_t first = 0; first < descs.size();) {
+        const auto &head = descs[first];
+        size_t last = first + 1;
+        while (last < descs.size() && descs[last].components_id == head.components_id &&
+               descs[last].shared_buffers == head.shared_buffers)
+            last++;
+
+        std::vector<const void *> shared_values(head.components_id.size(), nullptr);
+        for (size_t i = 0; i < head.components_id.size(); i++) {
+            if (!head.shared_buffers[i].empty())
+                shared_values[i] = head.shared_buffers[i].data();
         }
 
-        std::vector<void *> components_ptr;
-        components_ptr.resize(components_id.size());
-        ecs.allocateEntity(components_id, components_ptr, 1);
+        std::vector<void *> components_ptr(head.components_id.size());
+        // a batch ends at a chunk boundary; the remaining objects form the next batch
+        const size_t count = ecs.allocateEntity(head.components_id, components_ptr, last - first, shared_values).count;
 
-        for (int i = 0; const auto &component : components_json) {
-            GET_MODULE(ComponentInfoManager).loadByJson(components_ptr[i], component);
-            i++;
+        for (size_t i = 0; i < head.components_id.size(); i++) {
+            const auto index = mgr.getIndexFromComponentId(head.components_id[i]);
+            const auto storage = mgr.getStorageFromIndex(index);
+            // chunk values belong to the chunk and are initialised once when it is created
+            if (storage != ComponentStorage::Column)
+                continue;
+
+            const size_t stride = mgr.getSizeFromIndex(index);
+            auto *dst = static_cast<uint8_t *>(components_ptr[i]);
+            for (size_t k = 0; k < count; k++)
+                mgr.loadByJson(dst + stride * k, (*descs[first + k].components_json)[i]);
+            mgr.initComponents(head.components_id[i], dst, count);
         }
+
+        first += count;
+    }
+
+    if (!world_image.empty()) {
+        LOG_INFO(logger, "saving world image \"{}\"", world_image);
+        if (!ecs.saveWorldImage(world_image))
+            LOG_WARNING(logger, "world image \"{}\" skipped: the scene has components which are not trivially copyable",
+                        world_image);
     }
 }
 
@@ -0,0 +1,69 @@
+#include "mappedfile.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Pelican {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("failed to open file : " + path);
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+    sz = static_cast<size_t>(file_size.QuadPart);
+
+    // PAGE_WRITECOPY + FILE_MAP_COPY: writable view whose modified pages are private to this process
+    mapping_handle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_handle == nullptr)
+        throw std::runtime_error("failed to map file : " + path);
+
+    ptr = static_cast<uint8_t *>(MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0));
+    if (ptr == nullptr) {
+        CloseHandle(mapping_handle);
+        throw std::runtime_error("failed to map file : " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(ptr);
+    CloseHandle(mapping_handle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("failed to open file : " + path);
+
+    struct stat st;
+    fstat(fd, &st);
+    sz = static_cast<size_t>(st.st_size);
+
+    // MAP_PRIVATE: writable view whose modified pages are private to this process
+    void *mapped = mmap(nullptr, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw std::runtime_error("failed to map file : " + path);
+    ptr = static_cast<uint8_t *>(mapped);
+}
+
+MappedFile::~MappedFile() { munmap(ptr, sz); }
+
+#endif
+
+} // namespace Pelican
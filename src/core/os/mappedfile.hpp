@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Pelican {
+
+// Private (copy-on-write) mapping of a whole file.
+// Pages are read lazily on first access, and writes go to private copies which are never flushed back.
+class MappedFile {
+    uint8_t *ptr = nullptr;
+    size_t sz = 0;
+#ifdef _WIN32
+    void *mapping_handle = nullptr;
+#endif
+
+  public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    uint8_t *data() const { return ptr; }
+    size_t size() const { return sz; }
+};
+
+} // namespace Pelican
@@ -0,0 +1,158 @@
+#include "thread.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#endif
+
+namespace Pelican {
+
+#ifdef _WIN32
+
+std::vector<CpuCore> physicalCores() {
+    DWORD size = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &size);
+    std::vector<uint8_t> buf(size);
+    auto *info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buf.data());
+    if (size == 0 || !GetLogicalProcessorInformationEx(RelationProcessorCore, info, &size))
+        return {};
+
+    // EfficiencyClass is higher on faster cores; all zero on non-hybrid CPUs
+    std::vector<std::pair<int, BYTE>> cores;
+    BYTE max_class = 0;
+    for (DWORD offset = 0; offset < size;) {
+        const auto &entry = *reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *>(buf.data() + offset);
+        const auto &mask = entry.Processor.GroupMask[0];
+        // affinity masks only cover the first processor group
+        if (mask.Group == 0 && mask.Mask != 0) {
+            int first = 0;
+            while (!(mask.Mask & (KAFFINITY{1} << first)))
+                first++;
+            cores.emplace_back(first, entry.Processor.EfficiencyClass);
+            max_class = std::max(max_class, entry.Processor.EfficiencyClass);
+        }
+        offset += entry.Size;
+    }
+
+    std::vector<CpuCore> result;
+    for (const auto &[cpu, efficiency_class] : cores)
+        result.push_back({cpu, efficiency_class < max_class});
+    std::stable_sort(result.begin(), result.end(),
+                     [](const CpuCore &a, const CpuCore &b) { return !a.efficiency && b.efficiency; });
+    return result;
+}
+
+void setCurrentThreadName(const std::string &name) {
+    const std::wstring wide(name.begin(), name.end());
+    SetThreadDescription(GetCurrentThread(), wide.c_str());
+}
+
+bool pinCurrentThread(std::span<const int> cpus) {
+    DWORD_PTR mask = 0;
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+            mask |= DWORD_PTR{1} << cpu;
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+#elif defined(__linux__)
+
+namespace {
+
+const std::string SYSFS_CPU = "/sys/devices/system/cpu/";
+
+// sysfs cpu list format, e.g. "0-3,8,10-11"
+std::vector<int> readCpuList(const std::string &path) {
+    std::ifstream f{path};
+    std::string list;
+    std::vector<int> cpus;
+    if (!std::getline(f, list))
+        return cpus;
+
+    std::stringstream ss{list};
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty())
+            continue;
+        const auto dash = range.find('-');
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+int readInt(const std::string &path, int fallback) {
+    std::ifstream f{path};
+    int value;
+    return f >> value ? value : fallback;
+}
+
+} // namespace
+
+std::vector<CpuCore> physicalCores() {
+    const auto online = readCpuList(SYSFS_CPU + "online");
+    // hybrid Intel CPUs list their E-cores here; ARM big.LITTLE reports a lower capacity instead
+    const auto atom_cpus = readCpuList("/sys/devices/cpu_atom/cpus");
+
+    struct Core {
+        int cpu;
+        int capacity;
+    };
+    std::map<std::pair<int, int>, Core> cores; // by (package, core id)
+    int max_capacity = 0;
+    for (const int cpu : online) {
+        const auto dir = SYSFS_CPU + "cpu" + std::to_string(cpu) + "/";
+        const int package = readInt(dir + "topology/physical_package_id", 0);
+        const int core_id = readInt(dir + "topology/core_id", cpu);
+        int capacity = readInt(dir + "cpu_capacity", 1024);
+        if (std::find(atom_cpus.begin(), atom_cpus.end(), cpu) != atom_cpus.end())
+            capacity = 0;
+        max_capacity = std::max(max_capacity, capacity);
+        // SMT siblings share (package, core id); the lowest numbered one stands for the core
+        cores.try_emplace({package, core_id}, Core{cpu, capacity});
+    }
+
+    std::vector<CpuCore> result;
+    for (const auto &[key, core] : cores)
+        result.push_back({core.cpu, core.capacity < max_capacity});
+    std::sort(result.begin(), result.end(), [](const CpuCore &a, const CpuCore &b) {
+        return a.efficiency != b.efficiency ? !a.efficiency : a.cpu < b.cpu;
+    });
+    return result;
+}
+
+void setCurrentThreadName(const std::string &name) {
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+}
+
+bool pinCurrentThread(std::span<const int> cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return CPU_COUNT(&set) != 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+#else
+
+std::vector<CpuCore> physicalCores() { return {}; }
+void setCurrentThreadName(const std::string &) {}
+bool pinCurrentThread(std::span<const int>) { return false; }
+
+#endif
+
+} // namespace Pelican
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Pelican {
+
+// Physical core, represented by its first logical CPU
+struct CpuCore {
+    int cpu;
+    bool efficiency; // efficiency core of a hybrid CPU (E-core, LITTLE)
+};
+
+// Physical cores of the machine, performance cores first; empty when the topology is unknown
+std::vector<CpuCore> physicalCores();
+
+// Name shown by debuggers, perf and top (truncated to 15 characters on Linux)
+void setCurrentThreadName(const std::string &name);
+
+// Restrict the calling thread to the given logical CPUs; false when the OS refused or doesn't support it
+bool pinCurrentThread(std::span<const int> cpus);
+
+} // namespace Pelican
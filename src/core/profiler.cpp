@@ -45,6 +45,30 @@ void Profiler::End(const char* zone_name) {
     }
 }
 
+void Profiler::Counter(std::string_view name, double value) {
+    auto it = counters.find(name);
+    if (it == counters.end()) {
+        counters.emplace(std::string{name}, value);
+    } else {
+        it->second = value;
+    }
+#ifndef PELICAN_NO_LOG
+    if (logger) {
+        // LOG_INFO(logger, "Profiler: {} = {}", name, value);
+    } else {
+        std::cout << "Profiler: " << name << " = " << value << std::endl;
+    }
+#else
+    std::cout << "Profiler: " << name << " = " << value << std::endl;
+#endif
+}
+
+std::optional<double> Profiler::CounterValue(std::string_view name) const {
+    auto it = counters.find(name);
+    if (it == counters.end()) return std::nullopt;
+    return it->second;
+}
+
 void TimeProfilerStart(const char* zone_name) {
     Profiler::Get().Start(zone_name);
 }
@@ -53,4 +77,8 @@ void TimeProfilerEnd(const char* zone_name) {
     Profiler::Get().End(zone_name);
 }
 
+void TimeProfilerCounter(std::string_view name, double value) {
+    Profiler::Get().Counter(name, value);
+}
+
 } // namespace Pelican
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <functional>
+#include <optional>
 #include <unordered_map>
 
 namespace Pelican {
@@ -12,13 +15,28 @@ public:
 
     void Start(const char* zone_name);
     void End(const char* zone_name);
+    // Sample of a named value (queue depth, utilization...), reported next to the zones.
+    // Only the first sample of a name allocates; pass literals or names built once.
+    void Counter(std::string_view name, double value);
+
+    // Latest sample of a counter, e.g. for an overlay or a test
+    std::optional<double> CounterValue(std::string_view name) const;
+
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    using CounterMap = std::unordered_map<std::string, double, NameHash, std::equal_to<>>;
+    const CounterMap& Counters() const { return counters; }
 
 private:
     Profiler() = default;
     std::unordered_map<std::string, std::chrono::high_resolution_clock::time_point> start_times;
+    CounterMap counters; // latest sample of each counter
 };
 
 void TimeProfilerStart(const char* zone_name);
 void TimeProfilerEnd(const char* zone_name);
+void TimeProfilerCounter(std::string_view name, double value);
 
 } // namespace Pelican
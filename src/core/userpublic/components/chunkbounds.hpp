@@ -0,0 +1,16 @@
+#pragma once
+
+#include <geom/vec.hpp>
+
+namespace Pelican {
+
+// World-space AABB of every entity in a chunk (chunk component).
+// Kept up to date by ChunkBoundsSystem, so culling can reject a whole chunk with one test.
+struct ChunkBoundsComponent {
+    vec3 min;
+    vec3 max;
+
+    template <class T> void ref(T &ar) {}
+};
+
+} // namespace Pelican
@@ -2,9 +2,6 @@
 
 namespace Pelican {
 
-void SphereColliderComponent::init() {}
-void SphereColliderComponent::deinit() {}
-
 // void BoxColliderComponent::init() {}
 // void BoxColliderComponent::deinit() {}
 
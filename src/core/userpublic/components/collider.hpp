@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <details/ecs/entity.hpp>
+#include <details/ecs/event.hpp>
 #include <geom/vec.hpp>
 
 namespace Pelican {
@@ -14,9 +16,6 @@ struct SphereColliderComponent {
         ar.prop("pos", pos);
         ar.prop("radius", radius);
     }
-
-    void init();
-    void deinit();
 };
 
 // struct BoxColliderComponent {
@@ -33,4 +32,14 @@ struct SphereColliderComponent {
 //     void deinit();
 // };
 
+// Sent by SimpleCollisionSystem for every overlapping pair
+struct CollisionEvent {
+    EntityId a;
+    EntityId b;
+};
+
+namespace internal {
+EventChannel<CollisionEvent> &getCollisionEvents();
+}
+
 }  // namespace Pelican
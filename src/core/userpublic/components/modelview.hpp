@@ -10,7 +10,6 @@ namespace Pelican {
 
 struct SimpleModelViewUpdateComponent {
     std::string model_name;
-    uint8_t dirty;
 
     template <class T> void ref(T &ar) { ar.prop("model", model_name); }
 
@@ -21,12 +20,8 @@ struct SimpleModelViewUpdateComponent {
         model_name.clear();
         model_name.reserve(o.model_name.size());
         std::copy(o.model_name.begin(), o.model_name.end(), std::back_inserter(model_name));
-        dirty = o.dirty;
         return *this;
     }
-
-    void init() { dirty = true; }
-    void deinit() {}
 };
 
 } // namespace Pelican
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <components/chunkbounds.hpp>
 #include <components/collider.hpp>
 #include <components/localtransform.hpp>
 #include <components/modelview.hpp>
@@ -14,5 +15,6 @@ DECLARE_COMPONENT_CLASS(CameraComponent, 3);
 DECLARE_COMPONENT(LocalTransformComponent, 16);
 DECLARE_COMPONENT(SphereColliderComponent, 17);
 DECLARE_COMPONENT(SimpleModelViewUpdateComponent, 18);
+DECLARE_CHUNK_COMPONENT(ChunkBoundsComponent, 19);
 
 } // namespace Pelican
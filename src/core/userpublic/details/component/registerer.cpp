@@ -12,13 +12,16 @@ DECLARE_MODULE(UserComponentRegisterer) {
     UserComponentRegistererTemplatePublic &getPublicSub() { return sub; }
 };
 
-void UserComponentRegistererTemplatePublic::__registerComponent(ComponentId id, size_t sz, ComponentLoaderInfo loader) {
+void UserComponentRegistererTemplatePublic::__registerComponent(ComponentId id, size_t sz, ComponentStorage storage,
+                                                                ComponentLoaderInfo loader) {
     Pelican::ComponentInfo info;
     info.id = id;
     info.name = loader.name;
     info.size = sz;
-    info.cb_init = loader.init;
-    info.cb_deinit = loader.deinit;
+    info.storage = storage;
+    info.relocatable = loader.relocatable;
+    info.cb_init_range = loader.init_range;
+    info.cb_deinit_range = loader.deinit_range;
     info.cb_load_by_json2 = loader.json_loader;
 
     GET_MODULE(ComponentInfoManager).registerComponent(info);
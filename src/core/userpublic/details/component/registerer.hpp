@@ -5,6 +5,7 @@
 #include <serialize/jsonarchive.hpp>
 #include <serialize/serialize.hpp>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace Pelican {
@@ -14,33 +15,48 @@ namespace internal {
 class UserComponentRegistererTemplatePublic {
     struct ComponentLoaderInfo {
         std::string name;
-        void (*init)(void *ptr);
-        void (*deinit)(void *ptr);
+        bool relocatable; // trivially copyable
+        void (*init_range)(void *first, size_t count);   // nullptr without init()
+        void (*deinit_range)(void *first, size_t count); // nullptr without deinit()
         void (*json_loader)(void *component, JsonArchiveLoader &ar);
     };
 
-    void __registerComponent(ComponentId id, size_t sz, ComponentLoaderInfo loader);
+    void __registerComponent(ComponentId id, size_t sz, ComponentStorage storage, ComponentLoaderInfo loader);
 
   public:
     template <class Component>
         requires ISerializable<Component, JsonArchiveLoader>
     void registerComponent(std::string name) {
+        static_assert(ComponentStorageByType<Component>::value != ComponentStorage::Shared ||
+                          std::is_trivially_copyable_v<Component>,
+                      "shared components are compared bytewise and must be trivially copyable");
         __registerComponent(
-            ComponentIdByType<Component>::value, sizeof(Component),
+            ComponentIdByType<Component>::value, sizeof(Component), ComponentStorageByType<Component>::value,
             ComponentLoaderInfo{
                 .name = name,
-                .init =
-                    [](void *c) {
-                        if constexpr (requires(Component c) { c.init(); }) {
-                            static_cast<Component *>(c)->init();
-                        }
-                    },
-                .deinit =
-                    [](void *c) {
-                        if constexpr (requires(Component c) { c.deinit(); }) {
-                            static_cast<Component *>(c)->deinit();
-                        }
-                    },
+                .relocatable = std::is_trivially_copyable_v<Component>,
+                .init_range = []() -> void (*)(void *, size_t) {
+                    if constexpr (requires(Component c) { c.init(); }) {
+                        return [](void *first, size_t count) {
+                            auto *c = static_cast<Component *>(first);
+                            for (size_t i = 0; i < count; i++)
+                                c[i].init();
+                        };
+                    } else {
+                        return nullptr;
+                    }
+                }(),
+                .deinit_range = []() -> void (*)(void *, size_t) {
+                    if constexpr (requires(Component c) { c.deinit(); }) {
+                        return [](void *first, size_t count) {
+                            auto *c = static_cast<Component *>(first);
+                            for (size_t i = 0; i < count; i++)
+                                c[i].deinit();
+                        };
+                    } else {
+                        return nullptr;
+                    }
+                }(),
                 .json_loader = [](void *c, JsonArchiveLoader &ar) { static_cast<Component *>(c)->ref(ar); },
             });
     }
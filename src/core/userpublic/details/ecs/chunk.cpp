@@ -1,51 +1,242 @@
 #include "chunk.hpp"
 
 #include "componentdeclare.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iterator>
+#include <mutex>
+#include <new>
 #include "../../../ecs/componentinfo.hpp"
 
 namespace Pelican {
 
-ECSComponentChunk::ECSComponentChunk(std::span<const size_t> component_indices, std::span<const ComponentId> generic_ids) 
+namespace {
+
+// Hands out CHUNK_BLOCK_SIZE blocks carved from larger slabs. Freed blocks are reused, never returned to the OS.
+class ChunkBlockPool {
+    static constexpr size_t BLOCKS_PER_SLAB = 16;
+
+    std::mutex mutex;
+    std::vector<uint8_t *> free_blocks;
+
+  public:
+    static ChunkBlockPool &get() {
+        // never destroyed: chunks may be released during static destruction
+        static ChunkBlockPool *pool = new ChunkBlockPool;
+        return *pool;
+    }
+
+    uint8_t *acquire() {
+        std::lock_guard lock{mutex};
+        if (free_blocks.empty()) {
+            auto *slab = static_cast<uint8_t *>(::operator new(ChunkBlock::CHUNK_BLOCK_SIZE * BLOCKS_PER_SLAB,
+                                                               std::align_val_t{ChunkBlock::ALIGNMENT}));
+            for (size_t i = BLOCKS_PER_SLAB; i-- > 0;)
+                free_blocks.push_back(slab + ChunkBlock::CHUNK_BLOCK_SIZE * i);
+        }
+        auto *block = free_blocks.back();
+        free_blocks.pop_back();
+        return block;
+    }
+
+    void release(uint8_t *block) {
+        std::lock_guard lock{mutex};
+        free_blocks.push_back(block);
+    }
+};
+
+size_t alignUp(size_t value, size_t align) { return (value + align - 1) / align * align; }
+
+} // namespace
+
+ChunkBlock::ChunkBlock(size_t _size) : size{_size} {
+    if (size == CHUNK_BLOCK_SIZE) {
+        ptr = ChunkBlockPool::get().acquire();
+    } else {
+        ptr = static_cast<uint8_t *>(::operator new(size, std::align_val_t{ALIGNMENT}));
+    }
+}
+
+ChunkBlock::~ChunkBlock() {
+    if (!ptr) return;
+    if (size == CHUNK_BLOCK_SIZE) {
+        ChunkBlockPool::get().release(ptr);
+    } else {
+        ::operator delete(ptr, std::align_val_t{ALIGNMENT});
+    }
+}
+
+ChunkBlock &ChunkBlock::operator=(ChunkBlock &&other) noexcept {
+    if (this != &other) {
+        this->~ChunkBlock();
+        ptr = other.ptr;
+        size = other.size;
+        other.ptr = nullptr;
+    }
+    return *this;
+}
+
+ECSComponentChunk::ECSComponentChunk(std::span<const size_t> component_indices, std::span<const ComponentId> generic_ids,
+                                     bool allocate_block)
     : count{0}, component_ids(generic_ids.begin(), generic_ids.end()), indices(component_indices.begin(), component_indices.end()), mask{0} {
+    static std::atomic<uint64_t> serial_counter{0};
+    serial = ++serial_counter;
     
     size_t max_index = 0;
     for (const auto idx : indices) {
         if (idx > max_index) max_index = idx;
     }
     // Resize to Max Index
-    component_arrays.resize(max_index + 1);
+    columns.resize(max_index + 1);
+    component_storages.resize(max_index + 1, ComponentStorage::Column);
     component_versions.resize(max_index + 1, 0); // Initialize versions to 0
+    component_write_counts.resize(max_index + 1, 0);
+    enable_bits.resize(max_index + 1);
 
+    // Row capacity follows from the total row size: as many rows as fit the block after the single values
+    // and the alignment padding of every column
+    size_t single_bytes = 0;
+    size_t row_bytes = 0;
+    auto &mgr = GET_MODULE(ComponentInfoManager);
     for (const auto index : indices) {
-        auto& arr = component_arrays[index].emplace(GET_MODULE(ComponentInfoManager).getSizeFromIndex(index));
-        arr.reserve(CHUNK_CAPACITY);
         mask |= (1ULL << index);
+        component_storages[index] = mgr.getStorageFromIndex(index);
+        if (component_storages[index] == ComponentStorage::Tag) {
+            continue;
+        }
+
+        columns[index].stride = mgr.getSizeFromIndex(index);
+        if (isChunkComponent(index)) {
+            single_bytes += alignUp(columns[index].stride, ChunkBlock::ALIGNMENT);
+        } else {
+            row_bytes += columns[index].stride;
+            row_indices.push_back(index);
+        }
+    }
+
+    const size_t fixed_bytes = single_bytes + ChunkBlock::ALIGNMENT * row_indices.size();
+    block_size = ChunkBlock::CHUNK_BLOCK_SIZE;
+    row_capacity = fixed_bytes < block_size ? (block_size - fixed_bytes) / row_bytes : 0;
+    if (row_capacity < MIN_CHUNK_ROWS) {
+        row_capacity = MIN_CHUNK_ROWS;
+        block_size = alignUp(fixed_bytes + row_bytes * MIN_CHUNK_ROWS, ChunkBlock::ALIGNMENT);
+        if (block_size == ChunkBlock::CHUNK_BLOCK_SIZE) block_size += ChunkBlock::ALIGNMENT; // keep it out of the pool
+    }
+
+    size_t offset = 0;
+    for (const auto index : indices) {
+        if (component_storages[index] == ComponentStorage::Tag) continue;
+        columns[index].offset = offset;
+        offset = alignUp(offset + columns[index].stride * (isChunkComponent(index) ? 1 : row_capacity),
+                         ChunkBlock::ALIGNMENT);
+    }
+
+    if (allocate_block) {
+        block = ChunkBlock{block_size};
+        layoutColumns();
+        // single values start zeroed, as rows do
+        for (const auto index : indices) {
+            if (isChunkComponent(index)) std::memset(columns[index].data, 0, columns[index].stride);
+        }
     }
 }
 
+void ECSComponentChunk::layoutColumns() {
+    for (const auto index : indices) {
+        if (component_storages[index] == ComponentStorage::Tag) continue;
+        columns[index].data = block.data() + columns[index].offset;
+    }
+}
+
+void ECSComponentChunk::materialize() {
+    std::vector<const uint8_t *> sources(columns.size(), nullptr);
+    for (const auto index : indices) sources[index] = columns[index].data;
+
+    block = ChunkBlock{block_size};
+    layoutColumns();
+    for (const auto index : indices) {
+        if (!sources[index]) continue;
+        std::memcpy(columns[index].data, sources[index], columns[index].stride * (isChunkComponent(index) ? 1 : count));
+    }
+    external = false;
+}
+
 size_t ECSComponentChunk::allocate(std::span<const size_t> component_indices, std::span<void *> component_ptrs,
                                      size_t ex_count) {
+    ex_count = std::min(ex_count, row_capacity - std::min(count, row_capacity));
+    if (ex_count == 0) return 0;
+    if (external) materialize();
+
     size_t i = 0;
     for (const auto idx : component_indices) {
-        auto &arr = *component_arrays[idx];
-
-        auto old_count = arr.size();
-        arr.expand(ex_count);
-
-        component_ptrs[i] = arr.at(old_count);
-        i++;
+        auto &column = columns[idx];
+        if (!column.data) {
+            component_ptrs[i++] = nullptr; // tag
+        } else if (isChunkComponent(idx)) {
+            component_ptrs[i++] = column.data;
+        } else {
+            // new rows start zeroed
+            std::memset(column.data + column.stride * count, 0, column.stride * ex_count);
+            component_ptrs[i++] = column.data + column.stride * count;
+        }
     }
     count += ex_count;
+    for (const auto idx : indices) {
+        if (enable_bits[idx].disabled != 0) fitEnableBits(enable_bits[idx]);
+    }
     return ex_count;
 }
 
-void ECSComponentChunk::free(size_t ex_count) {
+void ECSComponentChunk::attach(size_t row_count, std::span<uint8_t *const> column_data) {
+    for (size_t i = 0; i < indices.size(); i++) {
+        columns[indices[i]].data = column_data[i]; // nullptr for tags
+    }
+    count = row_count;
+    external = true;
+}
+
+void ECSComponentChunk::restoreEnableWords(size_t index, std::span<const uint64_t> words) {
+    auto &bits = enable_bits[index];
+    bits.words.assign(words.begin(), words.end());
+    bits.disabled = 0;
+    for (size_t row = 0; row < count; row++) {
+        if (!(bits.words[row / 64] >> (row % 64) & 1)) bits.disabled++;
+    }
+}
+
+void ECSComponentChunk::fitEnableBits(EnableBits &bits) {
+    // new rows start enabled
+    if ((count + 63) / 64 > bits.words.size()) bits.words.resize((count + 63) / 64, ~0ULL);
+}
+
+void ECSComponentChunk::setEnabled(size_t index, size_t row, bool enabled) {
+    auto &bits = enable_bits[index];
+    if (enabled == isEnabled(index, row)) return;
+
+    fitEnableBits(bits);
+    if (enabled) {
+        bits.words[row / 64] |= (1ULL << (row % 64));
+        bits.disabled--;
+    } else {
+        bits.words[row / 64] &= ~(1ULL << (row % 64));
+        bits.disabled++;
+    }
+}
+
+void ECSComponentChunk::moveLastRowEnableBits(size_t row) {
+    const size_t last = count - 1;
     for (const auto idx : indices) {
-        auto &arr = *component_arrays[idx];
-        arr.shrink(ex_count);
+        auto &bits = enable_bits[idx];
+        if (bits.disabled == 0) continue;
+
+        if (!isEnabled(idx, row)) bits.disabled--;
+        const bool last_enabled = (bits.words[last / 64] >> (last % 64)) & 1;
+        bits.words[row / 64] = (bits.words[row / 64] & ~(1ULL << (row % 64))) | (uint64_t(last_enabled) << (row % 64));
+        bits.words[last / 64] |= (1ULL << (last % 64)); // the freed row reads as enabled when reused
     }
-    count -= ex_count;
 }
 
+void ECSComponentChunk::free(size_t ex_count) { count -= ex_count; }
+
 } // namespace Pelican
@@ -3,68 +3,109 @@
 #include <span>
 #include <unordered_map>
 #include <vector>
-#include <optional>
 #include <array>
+#include <bit>
 
 #include <details/ecs/component.hpp>
+#include <details/ecs/componentdeclare.hpp>
 
 namespace Pelican {
 
+// Fixed-size memory block holding all columns of one chunk.
+// Blocks of CHUNK_BLOCK_SIZE come from a pool; larger ones (archetypes with very wide rows) are allocated directly.
+class ChunkBlock {
+    uint8_t *ptr = nullptr;
+    size_t size = 0;
+
+  public:
+    static constexpr size_t CHUNK_BLOCK_SIZE = 64 * 1024;
+    static constexpr size_t ALIGNMENT = 64;
+
+    ChunkBlock() = default;
+    explicit ChunkBlock(size_t _size);
+    ~ChunkBlock();
+    ChunkBlock(ChunkBlock &&other) noexcept : ptr{other.ptr}, size{other.size} { other.ptr = nullptr; }
+    ChunkBlock &operator=(ChunkBlock &&other) noexcept;
+    ChunkBlock(const ChunkBlock &) = delete;
+    ChunkBlock &operator=(const ChunkBlock &) = delete;
+
+    uint8_t *data() const { return ptr; }
+};
+
 class ECSComponentChunk {
-    class VariedArray {
-        size_t count;
-        size_t stride;
-        std::vector<uint8_t> arr;
-
-      public:
-        VariedArray(size_t _stride) : count{0}, stride{_stride}, arr{} {}
-
-        size_t size() const { return count; }
-        size_t size_one() const { return stride; }
-        void *data() { return arr.data(); }
-        void *at(size_t index) { return static_cast<uint8_t *>(data()) + stride * index; }
-        void expand(size_t ex_count) {
-            arr.resize((count + ex_count) * stride);
-            count += ex_count;
-        }
-        void shrink(size_t shrink_count) {
-            arr.resize((count - shrink_count) * stride);
-            count -= shrink_count;
-        }
-        void reserve(size_t capacity) {
-            arr.reserve(capacity * stride);
-        }
+  public:
+    // archetypes with rows too wide for a pooled block get a larger block holding this many rows
+    static constexpr size_t MIN_CHUNK_ROWS = 16;
+
+  private:
+    struct Column {
+        uint8_t *data = nullptr; // nullptr for tags
+        size_t stride = 0;
+        size_t offset = 0; // from the beginning of the block
     };
 
+    ChunkBlock block;
+    size_t block_size = 0;
+    size_t row_capacity = 0;
+    bool external = false; // columns live in a mapped world image until the chunk has to grow
+
+    void layoutColumns();
+    void materialize();
 
     // Indexed by Dense Index
-    std::vector<std::optional<VariedArray>> component_arrays;
+    std::vector<Column> columns;
+    std::vector<ComponentStorage> component_storages;
     std::vector<size_t> indices;
+    std::vector<size_t> row_indices; // indices of per-entity (Column) components; tags have no array
     std::vector<ComponentId> component_ids;
     std::vector<uint64_t> component_versions; // Indexed by ComponentId (Dense Index)
+    std::vector<uint64_t> component_write_counts; // number of updateVersion() calls, for exact cache validation
+    uint64_t serial;                              // unique for the lifetime of the process
+    uint64_t row_exchanges = 0;                   // sorting moved rows between this and another chunk
     size_t count = 0;
     uint64_t mask = 0;
 
-  public:
-    static constexpr size_t CHUNK_CAPACITY = 4096;
+    // Per-row enable bits, allocated on the first disable of a component in this chunk
+    struct EnableBits {
+        std::vector<uint64_t> words; // bit set = enabled; empty means every row is enabled
+        size_t disabled = 0;
+    };
+    std::vector<EnableBits> enable_bits; // Indexed by Dense Index
+
+    void fitEnableBits(EnableBits &bits);
 
+  public:
     size_t size() const { return count; }
+    // rows that fit the block; the same for every chunk of an archetype
+    size_t capacity() const { return row_capacity; }
     uint64_t getMask() const { return mask; }
 
-    bool has(ComponentId component_id) {
-        if (component_id >= component_arrays.size())
+    bool has(ComponentId component_id) const {
+        if (component_id >= MAX_COMPONENTS)
             return false;
-        return component_arrays[component_id].has_value();
+        return (mask & (1ULL << component_id)) != 0;
     }
 
-    VariedArray &get(ComponentId component_id) { return *component_arrays[component_id]; }
-
+    // Tags have no data, so they are never versioned
     void updateVersion(size_t index, uint64_t tick) {
-        if (index < component_versions.size()) {
+        if (index < component_versions.size() && component_storages[index] != ComponentStorage::Tag) {
             component_versions[index] = tick;
+            component_write_counts[index]++;
         }
     }
 
+    uint64_t getWriteCount(size_t index) const { return component_write_counts[index]; }
+
+    // Rows of other entities were moved in by sorting. Values are unchanged, so write counts stay as they are
+    // (indices are keyed by entity); per-chunk aggregates see it through the version and getRowExchanges().
+    void markRowsExchanged(uint64_t tick) {
+        for (const auto index : row_indices)
+            component_versions[index] = tick;
+        row_exchanges++;
+    }
+    uint64_t getRowExchanges() const { return row_exchanges; }
+    uint64_t getSerial() const { return serial; }
+
     uint64_t getVersion(size_t index) const {
         if (index < component_versions.size()) {
             return component_versions[index];
@@ -85,19 +126,88 @@ class ECSComponentChunk {
     }
 
     ComponentRef getRef(size_t index) {
-        return ComponentRef{
-            .ptr = component_arrays[index]->data(),
-            .stride = component_arrays[index]->size_one()
-        };
+        return ComponentRef{.ptr = columns[index].data, .stride = columns[index].stride}; // nullptr for tags
+    }
+
+    // Read-only column (or single value) of a component, nullptr for tags
+    const void *getData(size_t index) const { return columns[index].data; }
+
+    bool isEnabled(size_t index, size_t row) const {
+        const auto &bits = enable_bits[index];
+        return bits.disabled == 0 || (bits.words[row / 64] >> (row % 64) & 1);
+    }
+    void setEnabled(size_t index, size_t row, bool enabled);
+
+    // true if no row has any of the components disabled (whole chunk fast path)
+    bool allEnabled(std::span<const size_t> req_indices) const {
+        for (auto idx : req_indices) {
+            if (enable_bits[idx].disabled != 0) return false;
+        }
+        return true;
+    }
+
+    // Calls f(begin, end) for every run of rows which have all of req_indices enabled
+    template <class F> void forEachEnabledRun(std::span<const size_t> req_indices, F &&f) const {
+        const size_t word_count = (count + 63) / 64;
+        size_t run_begin = 0;
+        bool in_run = false;
+        for (size_t w = 0; w < word_count; w++) {
+            uint64_t word = ~0ULL;
+            for (auto idx : req_indices) {
+                if (enable_bits[idx].disabled != 0) word &= enable_bits[idx].words[w];
+            }
+            if (w == word_count - 1 && count % 64 != 0) word &= (1ULL << (count % 64)) - 1;
+
+            // walk transitions between enabled and disabled rows
+            size_t bit = 0;
+            while (bit < 64) {
+                const uint64_t rest = word >> bit;
+                if (!in_run) {
+                    if (rest == 0) break;
+                    bit += std::countr_zero(rest);
+                    run_begin = w * 64 + bit;
+                    in_run = true;
+                } else {
+                    bit += std::countr_one(rest);
+                    if (bit >= 64) break; // run continues into the next word
+                    f(run_begin, w * 64 + bit);
+                    in_run = false;
+                }
+            }
+        }
+        if (in_run) f(run_begin, count);
     }
 
+    // Row `row` is overwritten by the last row (swap and erase); call before free(1)
+    void moveLastRowEnableBits(size_t row);
+
     std::span<const ComponentId> getComponentList() const { return component_ids; }
     std::span<const size_t> getIndices() const { return indices; }
-    
-    // Chunk Constructor
-    ECSComponentChunk(std::span<const size_t> component_indices, std::span<const ComponentId> generic_ids);
+    std::span<const size_t> getRowIndices() const { return row_indices; }
+
+    // Chunk and shared components hold a single value for the whole chunk
+    bool isChunkComponent(size_t index) const {
+        return component_storages[index] == ComponentStorage::Chunk ||
+               component_storages[index] == ComponentStorage::Shared;
+    }
+    void *getChunkComponent(size_t index) { return columns[index].data; }
+    ComponentStorage getStorage(size_t index) const { return component_storages[index]; }
+
+    // Enable words of a component, empty while every row is enabled
+    std::span<const uint64_t> getEnableWords(size_t index) const {
+        return enable_bits[index].disabled == 0 ? std::span<const uint64_t>{} : enable_bits[index].words;
+    }
+    void restoreEnableWords(size_t index, std::span<const uint64_t> words);
+
+    // Uses externally owned memory (a mapped world image) as the columns of an empty chunk.
+    // column_data is parallel to getIndices(); the rows are copied into a block once the chunk has to grow.
+    void attach(size_t row_count, std::span<uint8_t *const> column_data);
+
+    // Chunk Constructor. Without allocate_block, memory is only acquired on the first allocation.
+    ECSComponentChunk(std::span<const size_t> component_indices, std::span<const ComponentId> generic_ids,
+                      bool allocate_block = true);
 
-    // returns allocated count
+    // returns allocated count, which is less than ex_count when the chunk becomes full
     size_t allocate(std::span<const size_t> component_indices, std::span<void *> component_ptrs, size_t ex_count);
 
     void free(size_t free_count);
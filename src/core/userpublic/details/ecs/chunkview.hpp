@@ -0,0 +1,140 @@
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <type_traits>
+
+#include <details/ecs/componentdeclare.hpp>
+
+#if defined(_MSC_VER)
+#define PELICAN_RESTRICT __restrict
+#else
+#define PELICAN_RESTRICT __restrict__
+#endif
+
+namespace Pelican {
+
+namespace internal {
+
+template <class T>
+constexpr ComponentStorage storageOf = ComponentStorageByType<std::remove_const_t<T>>::value;
+
+// Element `i` of a query column. Chunk/shared components have one value, tags have none.
+template <class T> inline T &rowAt(T *ptr, size_t i) {
+    if constexpr (storageOf<T> == ComponentStorage::Tag) {
+        static std::remove_const_t<T> empty{};
+        return empty;
+    } else if constexpr (storageOf<T> == ComponentStorage::Column) {
+        return ptr[i];
+    } else {
+        return *ptr;
+    }
+}
+
+template <class T> inline T *assumeAligned(T *ptr) {
+    if constexpr (storageOf<T> == ComponentStorage::Column) {
+        return std::assume_aligned<alignof(T)>(ptr);
+    } else {
+        return ptr;
+    }
+}
+
+// A query column as a span: one element per row for columns, the single value for chunk/shared components, empty for tags
+template <class T> inline std::span<T> columnSpan(T *ptr, size_t count) {
+    if constexpr (storageOf<T> == ComponentStorage::Tag) {
+        return {};
+    } else if constexpr (storageOf<T> == ComponentStorage::Column) {
+        return std::span<T>{assumeAligned(ptr), count};
+    } else {
+        return std::span<T>{ptr, 1};
+    }
+}
+
+// The columns of one chunk never alias, so the pointers are restrict-qualified to let the loop vectorize
+template <class F, class... T> inline void eachRow(size_t count, F &f, T *PELICAN_RESTRICT... ptrs) {
+    for (size_t i = 0; i < count; i++) {
+        f(rowAt(ptrs, i)...);
+    }
+}
+
+} // namespace internal
+
+class ECSComponentChunk;
+
+// Columns of one chunk (or of a run of enabled rows in it).
+// For chunk components the pointer refers to the single value of the chunk.
+template <class... TComponents>
+struct ChunkView {
+    std::tuple<TComponents*...> components;
+    size_t count;
+    const ECSComponentChunk *chunk = nullptr; // source chunk, when provided by the core
+    size_t first_row = 0;                      // row of components[0] within the chunk
+
+    size_t size() const { return count; }
+
+    template <size_t I> auto column() const {
+        using T = std::tuple_element_t<I, std::tuple<TComponents...>>;
+        return internal::columnSpan(std::get<I>(components), count);
+    }
+    template <class T> std::span<T> column() const {
+        return internal::columnSpan(std::get<T *>(components), count);
+    }
+
+    // Calls f(TComponents&...) for every row
+    template <class F> void each(F &&f) const {
+        std::apply([&](auto... ptrs) { internal::eachRow(count, f, internal::assumeAligned(ptrs)...); }, components);
+    }
+
+    // Random access range of std::tuple<TComponents&...>, for range-for and std::ranges algorithms
+    class RowIterator {
+        std::tuple<TComponents*...> ptrs{};
+        std::ptrdiff_t index = 0;
+
+      public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = std::tuple<TComponents&...>;
+        using reference = std::tuple<TComponents&...>;
+        using difference_type = std::ptrdiff_t;
+
+        RowIterator() = default;
+        RowIterator(std::tuple<TComponents*...> _ptrs, std::ptrdiff_t _index) : ptrs{_ptrs}, index{_index} {}
+
+        reference operator*() const {
+            return std::apply([&](auto... p) { return reference{internal::rowAt(p, index)...}; }, ptrs);
+        }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        RowIterator &operator++() { index++; return *this; }
+        RowIterator operator++(int) { auto tmp = *this; index++; return tmp; }
+        RowIterator &operator--() { index--; return *this; }
+        RowIterator operator--(int) { auto tmp = *this; index--; return tmp; }
+        RowIterator &operator+=(difference_type n) { index += n; return *this; }
+        RowIterator &operator-=(difference_type n) { index -= n; return *this; }
+        friend RowIterator operator+(RowIterator it, difference_type n) { return it += n; }
+        friend RowIterator operator+(difference_type n, RowIterator it) { return it += n; }
+        friend RowIterator operator-(RowIterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const RowIterator &a, const RowIterator &b) { return a.index - b.index; }
+
+        friend bool operator==(const RowIterator &a, const RowIterator &b) { return a.index == b.index; }
+        friend auto operator<=>(const RowIterator &a, const RowIterator &b) { return a.index <=> b.index; }
+    };
+
+    class RowRange : public std::ranges::view_interface<RowRange> {
+        std::tuple<TComponents*...> ptrs{};
+        size_t count = 0;
+
+      public:
+        RowRange() = default;
+        RowRange(std::tuple<TComponents*...> _ptrs, size_t _count) : ptrs{_ptrs}, count{_count} {}
+        RowIterator begin() const { return RowIterator{ptrs, 0}; }
+        RowIterator end() const { return RowIterator{ptrs, static_cast<std::ptrdiff_t>(count)}; }
+    };
+
+    RowRange rows() const { return RowRange{components, count}; }
+};
+
+} // namespace Pelican
@@ -6,6 +6,13 @@ namespace Pelican {
 
 using ComponentId = uint64_t;
 
+enum class ComponentStorage : uint8_t {
+    Column, // one value per entity
+    Chunk,  // one value per chunk, shared by all entities in it
+    Tag,    // no data; exists only in the archetype mask
+    Shared, // one value per chunk which is part of the chunk key; equal values share chunks
+};
+
 struct ComponentRef {
     void* ptr;
     size_t stride;
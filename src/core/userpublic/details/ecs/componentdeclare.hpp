@@ -2,16 +2,36 @@
 
 #include <details/ecs/component.hpp>
 #include <details/ecs/entity.hpp>
+#include <type_traits>
 
 namespace Pelican {
 
 template <class T> struct ComponentIdByType;
 
+// empty structs are detected as tags
+template <class T> struct ComponentStorageByType {
+    static constexpr ComponentStorage value = std::is_empty_v<T> ? ComponentStorage::Tag : ComponentStorage::Column;
+};
+
 #define DECLARE_COMPONENT(_name, _id)                                                                                  \
     template <> struct Pelican::ComponentIdByType<_name> {                                                             \
         static constexpr ComponentId value = _id;                                                                      \
     };
 
+// one value per chunk instead of per entity
+#define DECLARE_CHUNK_COMPONENT(_name, _id)                                                                            \
+    DECLARE_COMPONENT(_name, _id);                                                                                     \
+    template <> struct Pelican::ComponentStorageByType<_name> {                                                        \
+        static constexpr ComponentStorage value = ComponentStorage::Chunk;                                             \
+    };
+
+// value shared by every entity of a chunk; entities are grouped into chunks by this value (compared bytewise)
+#define DECLARE_SHARED_COMPONENT(_name, _id)                                                                           \
+    DECLARE_COMPONENT(_name, _id);                                                                                     \
+    template <> struct Pelican::ComponentStorageByType<_name> {                                                        \
+        static constexpr ComponentStorage value = ComponentStorage::Shared;                                            \
+    };
+
 #define DECLARE_COMPONENT_CLASS(_name, _id)                                                                            \
     class _name;                                                                                                       \
     DECLARE_COMPONENT(_name, _id);
@@ -3,12 +3,15 @@
 #include "coretemplate.hpp"
 #include "coretemplate.hpp"
 #include "../../../profiler.hpp"
+#include "../../../job_graph.hpp"
 #include "../../../job_system.hpp"
 #include "../../../container.hpp"
 #include "../../../ecs/componentinfo.hpp"
 
+#include <optional>
 #include <queue>
 #include <algorithm>
+#include <stdexcept>
 
 namespace Pelican {
 
@@ -17,6 +20,16 @@ namespace internal {
         auto& mgr = GET_MODULE(ComponentInfoManager);
         return mgr.getIndexFromComponentId(id);
     }
+
+    size_t getJobThreadIndex() {
+        const size_t index = JobSystem::threadIndex();
+        // slot 0 belongs to the main thread; other threads outside the job system have none
+        if (index == 0 && !JobSystem::Get().isMainThread()) return SIZE_MAX;
+        return index;
+    }
+
+    // doesn't start the job system: init() must see the configured settings first
+    size_t getJobThreadSlotCount() { return JobSystem::Get().threadSlotCount(); }
 }
 
 void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
@@ -28,13 +41,13 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
     }
 }
 
-    EntityId ECSCoreTemplatePublic::allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs,
-                                 size_t count) {
+    EntityBatch ECSCoreTemplatePublic::allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs,
+                                 size_t count, std::span<const void *const> shared_values) {
     TimeProfilerStart("ECS_AllocateEntity");
     // Entity id is recorded as implicit component
     ComponentId component_ids_ex[65]; // MAX_COMPONENTS + 1
     size_t ex_size = component_ids.size() + 1;
-    if(ex_size > 65) { return 1; }
+    if(ex_size > 65) { throw std::runtime_error("too many components for one entity"); }
     component_ids_ex[0] = ComponentIdByType<EntityId>::value;
     for(size_t i=0; i<component_ids.size();++i) component_ids_ex[i+1] = component_ids[i];
 
@@ -48,6 +61,22 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
     // Sort component IDs to form the archetype key
     std::vector<ComponentId> archetype_key(component_ids_ex, component_ids_ex + ex_size);
     std::sort(archetype_key.begin(), archetype_key.end());
+
+    // Values of shared components are part of the chunk key (appended in sorted id order)
+    const size_t archetype_key_size = archetype_key.size();
+    for (size_t k = 0; k < archetype_key_size; k++) {
+        const auto idx = mgr.getIndexFromComponentId(archetype_key[k]);
+        if (mgr.getStorageFromIndex(idx) != ComponentStorage::Shared) continue;
+
+        const void *value = nullptr;
+        for (size_t i = 0; i < component_ids.size() && i < shared_values.size(); i++) {
+            if (component_ids[i] == archetype_key[k]) value = shared_values[i];
+        }
+        const size_t size = mgr.getSizeFromIndex(idx);
+        const size_t offset = archetype_key.size();
+        archetype_key.resize(offset + (size + sizeof(ComponentId) - 1) / sizeof(ComponentId), 0);
+        if (value) std::memcpy(archetype_key.data() + offset, value, size);
+    }
     
     // find suitable chunk using archetype index
     ChunkIndex chunk_index = UINT32_MAX;
@@ -55,7 +84,7 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
     auto it = archetype_to_chunks.find(archetype_key);
     if (it != archetype_to_chunks.end()) {
         for (auto idx : it->second) {
-            if (chunks_storage[idx].size() + count <= ECSComponentChunk::CHUNK_CAPACITY) {
+            if (chunks_storage[idx].size() < chunks_storage[idx].capacity()) {
                 chunk_index = idx;
                 break; 
             }
@@ -72,6 +101,22 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
         chunk_index = chunks_storage.size();
         // Construct with INDICES and GENERIC IDs
         chunks_storage.emplace_back(std::span(component_indices_ex), std::span(component_ids_ex, ex_size));
+
+        // Store shared values once in the chunk
+        for (size_t i = 0; i < component_ids.size() && i < shared_values.size(); i++) {
+            const auto idx = component_indices_ex[i + 1];
+            if (shared_values[i] && mgr.getStorageFromIndex(idx) == ComponentStorage::Shared) {
+                std::memcpy(chunks_storage[chunk_index].getChunkComponent(idx), shared_values[i],
+                            mgr.getSizeFromIndex(idx));
+            }
+        }
+        // Chunk components belong to the chunk: initialised once here, not per entity
+        for (size_t i = 0; i < ex_size; i++) {
+            if (mgr.getStorageFromIndex(component_indices_ex[i]) == ComponentStorage::Chunk) {
+                mgr.initComponents(component_ids_ex[i],
+                                   chunks_storage[chunk_index].getChunkComponent(component_indices_ex[i]), 1);
+            }
+        }
         
         // Register in archetype map
         archetype_to_chunks[archetype_key].push_back(chunk_index);
@@ -85,6 +130,7 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
     std::vector<void *> component_ptrs_ex(component_ids.size() + 1);
     
     const auto allocated_count = chunks_storage[chunk_index].allocate(component_indices_ex, component_ptrs_ex, count);
+    count = allocated_count;
     
     // Set version of all components in this chunk to global_tick
     for(auto idx : component_indices_ex) {
@@ -100,26 +146,41 @@ void ECSCoreTemplatePublic::updateSystemChunkCache(ChunkIndex chunk_index) {
             .chunk_index = chunk_index,
             .array_index = static_cast<WithinChunkIndex>(first_index + i),
         };
-        entity_ids[i] = id_to_ref.size();
+        entity_ids[first_index + i] = id_to_ref.size();
         id_to_ref.emplace_back(entity_ref);
     }
 
+    pending_adds.push_back({entity_id_first, count});
+
     TimeProfilerEnd("ECS_AllocateEntity");
-    return entity_id_first;
+    return EntityBatch{entity_id_first, count};
 }
 
 void ECSCoreTemplatePublic::remove(EntityId id) {
     const auto ref = id_to_ref[id];
+    if (ref.chunk_index == INVALID_CHUNK_INDEX) return;
     auto &chunk = chunks_storage[ref.chunk_index];
 
+    notifyObservers(ObserverTrigger::OnRemove, RowsByChunk{{ref.chunk_index, {ref.array_index}}});
+
     // Get EntityId component array using Dense Index
     auto& mgr = GET_MODULE(ComponentInfoManager);
     size_t entity_id_idx = mgr.getIndexFromComponentId(ComponentIdByType<EntityId>::value);
 
     EntityId moved_id = static_cast<EntityId *>(chunk.getRef(entity_id_idx).ptr)[chunk.size() - 1];
 
+    const auto chunk_indices = chunk.getIndices();
+    for (size_t i = 0; i < chunk_indices.size(); i++) {
+        if (chunk.getStorage(chunk_indices[i]) != ComponentStorage::Column) continue;
+        auto component_arr = chunk.getRef(chunk_indices[i]);
+        mgr.deinitComponents(chunk.getComponentList()[i],
+                             static_cast<uint8_t *>(component_arr.ptr) + component_arr.stride * ref.array_index, 1);
+    }
+
+    chunk.moveLastRowEnableBits(ref.array_index);
+
     // Swap and erase
-    for (const auto index : chunk.getIndices()) {
+    for (const auto index : chunk.getRowIndices()) {
         auto component_arr = chunk.getRef(index);
 
         auto ptr = static_cast<uint8_t *>(component_arr.ptr);
@@ -127,25 +188,273 @@ void ECSCoreTemplatePublic::remove(EntityId id) {
         std::memcpy(ptr + stride * ref.array_index, ptr + stride * (chunk.size() - 1), stride);
     }
 
+    for (auto index : secondary_indices) {
+        if (chunk.getMask() >> index->getComponentIndex() & 1)
+            index->erase(id);
+    }
+
     chunks_storage[ref.chunk_index].free(1);
     id_to_ref[moved_id].array_index = ref.array_index;
+    id_to_ref[id].chunk_index = INVALID_CHUNK_INDEX;
 }
 
 void ECSCoreTemplatePublic::compaction() { /* TODO */ }
 
+void ECSCoreTemplatePublic::setSystemAffinity(SystemId system_id, SystemAffinity affinity,
+                                              const std::string &thread_name) {
+    auto &sys = systems.at(system_id);
+    sys.affinity = affinity;
+    if (affinity == SystemAffinity::DedicatedThread) {
+        sys.dedicated_thread = JobSystem::Get().dedicatedThread(thread_name);
+    }
+    system_graph_dirty = true;
+}
+
+void ECSCoreTemplatePublic::setEnabled(EntityId id, ComponentId component_id, bool enabled) {
+    const auto ref = id_to_ref[id];
+    if (ref.chunk_index == INVALID_CHUNK_INDEX) return;
+    auto &chunk = chunks_storage[ref.chunk_index];
+    const auto index = internal::getIndexFromComponentId_Ref(component_id);
+    if (!chunk.has(index) || chunk.isChunkComponent(index)) return;
+
+    if (chunk.isEnabled(index, ref.array_index) != enabled) {
+        chunk.setEnabled(index, ref.array_index, enabled);
+        chunk.updateVersion(index, global_tick);
+    }
+}
+
+bool ECSCoreTemplatePublic::isEnabled(EntityId id, ComponentId component_id) const {
+    const auto ref = id_to_ref[id];
+    if (ref.chunk_index == INVALID_CHUNK_INDEX) return false;
+    const auto index = internal::getIndexFromComponentId_Ref(component_id);
+    const auto &chunk = chunks_storage[ref.chunk_index];
+    // same rule as setEnabled: only row components of the entity have enable bits
+    if (!chunk.has(index) || chunk.isChunkComponent(index)) return false;
+    return chunk.isEnabled(index, ref.array_index);
+}
+
 void ECSCoreTemplatePublic::unregisterSystem(SystemId system_id) {
     for (const auto depends : systems.at(system_id).depends_list) {
         systems.at(depends).depended_by.erase(system_id);
     }
     systems.erase(system_id);
+    system_graph_dirty = true;
 }
 
-void ECSCoreTemplatePublic::update() {
-    global_tick++; 
-    JobSystem::Get().init(); 
+void ECSCoreTemplatePublic::unregisterObserver(ObserverId observer_id) { observers.erase(observer_id); }
 
-    TimeProfilerStart("ECS_Update_Sort");
-    
+void ECSCoreTemplatePublic::notifyObservers(ObserverTrigger trigger, const RowsByChunk &rows) {
+    RowsByChunk matched;
+    for (auto &[id, obs] : observers) {
+        if (obs.trigger != trigger) continue;
+
+        matched.clear();
+        for (const auto &entry : rows) {
+            if ((chunks_storage[entry.first].getMask() & obs.matching_mask) == obs.matching_mask) {
+                matched.push_back(entry);
+            }
+        }
+        if (!matched.empty()) {
+            obs.p_func(*this, obs.observer_ref, matched, obs.component_indices);
+        }
+    }
+}
+
+void ECSCoreTemplatePublic::flushPendingAdds() {
+    if (pending_adds.empty()) return;
+
+    // delivered to the observers registered now, not at allocation time
+    const bool has_add_observer = std::any_of(observers.begin(), observers.end(),
+                                              [](const auto &o) { return o.second.trigger == ObserverTrigger::OnAdd; });
+    if (!has_add_observer) {
+        pending_adds.clear();
+        return;
+    }
+
+    // Resolve current rows (entities may have been moved or removed since allocation)
+    std::vector<EntityRef> refs;
+    for (const auto &add : pending_adds) {
+        for (EntityId id = add.first; id < add.first + add.count; id++) {
+            if (id_to_ref[id].chunk_index != INVALID_CHUNK_INDEX) {
+                refs.push_back(id_to_ref[id]);
+            }
+        }
+    }
+    pending_adds.clear();
+
+    std::sort(refs.begin(), refs.end(), [](const EntityRef &a, const EntityRef &b) {
+        return a.chunk_index != b.chunk_index ? a.chunk_index < b.chunk_index : a.array_index < b.array_index;
+    });
+
+    RowsByChunk rows;
+    for (const auto &ref : refs) {
+        if (rows.empty() || rows.back().first != ref.chunk_index) {
+            rows.push_back({ref.chunk_index, {}});
+        }
+        rows.back().second.push_back(ref.array_index);
+    }
+
+    notifyObservers(ObserverTrigger::OnAdd, rows);
+}
+
+void ECSCoreTemplatePublic::setSortKeyRaw(size_t component_index, std::function<uint64_t(const void *)> key) {
+    std::erase_if(sort_keys, [&](const SortKey &k) { return k.component_index == component_index; });
+    sort_keys.push_back(SortKey{component_index, std::move(key)});
+}
+
+void ECSCoreTemplatePublic::applyRowOrder(ChunkIndex a, ChunkIndex b, const std::vector<size_t> &order) {
+    auto &chunk_a = chunks_storage[a];
+    const size_t count_a = chunk_a.size();
+    const auto total = order.size();
+
+    auto row_ptr = [&](size_t index, size_t combined) -> uint8_t * {
+        auto &chunk = combined < count_a ? chunk_a : chunks_storage[b];
+        const size_t row = combined < count_a ? combined : combined - count_a;
+        auto ref = chunk.getRef(index);
+        return static_cast<uint8_t *>(ref.ptr) + ref.stride * row;
+    };
+
+    // gather into a temporary buffer, then write back in the new order
+    std::vector<uint8_t> tmp;
+    for (const auto index : chunk_a.getRowIndices()) {
+        const size_t stride = chunk_a.getRef(index).stride;
+        tmp.resize(stride * total);
+        for (size_t i = 0; i < total; i++) {
+            std::memcpy(tmp.data() + stride * i, row_ptr(index, order[i]), stride);
+        }
+        for (size_t i = 0; i < total; i++) {
+            std::memcpy(row_ptr(index, i), tmp.data() + stride * i, stride);
+        }
+    }
+
+    // every entity keeps its values, so only an exchange between the chunks is a change to them
+    bool exchanged = false;
+    for (size_t i = 0; i < count_a && !exchanged; i++) exchanged = order[i] >= count_a;
+    if (exchanged) {
+        chunk_a.markRowsExchanged(global_tick);
+        chunks_storage[b].markRowsExchanged(global_tick);
+    }
+
+    auto enabled = [&](size_t index, size_t combined) {
+        return combined < count_a ? chunk_a.isEnabled(index, combined)
+                                  : chunks_storage[b].isEnabled(index, combined - count_a);
+    };
+    std::vector<bool> bits(total);
+    for (const auto index : chunk_a.getIndices()) {
+        if (chunk_a.isChunkComponent(index)) continue;
+        const size_t one_index[] = {index};
+        if (chunk_a.allEnabled(one_index) && (b == INVALID_CHUNK_INDEX || chunks_storage[b].allEnabled(one_index)))
+            continue;
+        for (size_t i = 0; i < total; i++) bits[i] = enabled(index, order[i]);
+        for (size_t i = 0; i < total; i++) {
+            if (i < count_a) chunk_a.setEnabled(index, i, bits[i]);
+            else chunks_storage[b].setEnabled(index, i - count_a, bits[i]);
+        }
+    }
+
+    // entities moved: fix the id table
+    const size_t entity_id_idx = internal::getIndexFromComponentId_Ref(ComponentIdByType<EntityId>::value);
+    for (size_t i = 0; i < total; i++) {
+        const auto id = *reinterpret_cast<const EntityId *>(row_ptr(entity_id_idx, i));
+        id_to_ref[id] = i < count_a ? EntityRef{a, i} : EntityRef{b, i - count_a};
+    }
+}
+
+void ECSCoreTemplatePublic::sortStep(const SortKey &sort_key, const std::vector<ChunkIndex> &chunks, size_t position) {
+    // sort chunk `position` and merge it with the next chunk (odd-even transposition over chunks)
+    const ChunkIndex a = chunks[position];
+    const ChunkIndex b = position + 1 < chunks.size() ? chunks[position + 1] : INVALID_CHUNK_INDEX;
+
+    std::vector<uint64_t> keys;
+    for (const auto chunk_index : {a, b}) {
+        if (chunk_index == INVALID_CHUNK_INDEX) continue;
+        auto &chunk = chunks_storage[chunk_index];
+        auto ref = chunk.getRef(sort_key.component_index);
+        for (size_t row = 0; row < chunk.size(); row++) {
+            keys.push_back(sort_key.key(static_cast<const uint8_t *>(ref.ptr) + ref.stride * row));
+        }
+    }
+    if (std::is_sorted(keys.begin(), keys.end())) return;
+
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t p, size_t q) { return keys[p] < keys[q]; });
+    applyRowOrder(a, b, order);
+}
+
+void ECSCoreTemplatePublic::incrementalSort() {
+    if (sort_keys.empty()) return;
+
+    // (sort key, chunk list) pairs to walk through
+    std::vector<std::pair<const SortKey *, const std::vector<ChunkIndex> *>> groups;
+    size_t total_steps = 0;
+    auto &mgr = GET_MODULE(ComponentInfoManager);
+    for (const auto &[key, chunks] : archetype_to_chunks) {
+        if (chunks.empty()) continue;
+        const auto &front = chunks_storage[chunks.front()];
+        // rows are moved with memcpy, which would break e.g. a std::string member
+        const auto rows = front.getRowIndices();
+        if (!std::all_of(rows.begin(), rows.end(), [&](size_t index) { return mgr.isRelocatableFromIndex(index); }))
+            continue;
+        const auto mask = front.getMask();
+        for (const auto &sort_key : sort_keys) {
+            if (mask & (1ULL << sort_key.component_index)) {
+                groups.push_back({&sort_key, &chunks});
+                total_steps += chunks.size();
+                break;
+            }
+        }
+    }
+    if (total_steps == 0) return;
+
+    TimeProfilerStart("ECS_Update_IncrementalSort");
+    for (size_t step = 0; step < sort_budget && step < total_steps; step++) {
+        size_t position = sort_cursor++ % total_steps;
+        for (const auto &[sort_key, chunks] : groups) {
+            if (position < chunks->size()) {
+                sortStep(*sort_key, *chunks, position);
+                break;
+            }
+            position -= chunks->size();
+        }
+    }
+    TimeProfilerEnd("ECS_Update_IncrementalSort");
+}
+
+void ECSCoreTemplatePublic::registerEventChannel(EventChannelBase &channel) { event_channels.push_back(&channel); }
+
+void ECSCoreTemplatePublic::unregisterEventChannel(EventChannelBase &channel) {
+    std::erase(event_channels, &channel);
+}
+
+void ECSCoreTemplatePublic::refreshIndex(ComponentIndexBase &index) {
+    auto &mgr = GET_MODULE(ComponentInfoManager);
+    const size_t entity_id_idx = mgr.getIndexFromComponentId(ComponentIdByType<EntityId>::value);
+
+    for (const auto &chunk : chunks_storage) {
+        if (chunk.size() == 0 || !(chunk.getMask() >> index.getComponentIndex() & 1))
+            continue;
+        index.refresh(chunk, static_cast<const EntityId *>(chunk.getData(entity_id_idx)));
+    }
+}
+
+void ECSCoreTemplatePublic::registerIndex(ComponentIndexBase &index) {
+    secondary_indices.push_back(&index);
+    refreshIndex(index);
+}
+
+void ECSCoreTemplatePublic::unregisterIndex(ComponentIndexBase &index) { std::erase(secondary_indices, &index); }
+
+void ECSCoreTemplatePublic::refreshIndices() {
+    if (secondary_indices.empty()) return;
+    TimeProfilerStart("ECS_Update_RefreshIndices");
+    for (auto index : secondary_indices) {
+        refreshIndex(*index);
+    }
+    TimeProfilerEnd("ECS_Update_RefreshIndices");
+}
+
+void ECSCoreTemplatePublic::rebuildSystemGraph() {
     // Level-based Topological Sort
     std::unordered_map<SystemId, size_t> in_degree;
     std::queue<SystemId> zero_degree_queue; 
@@ -179,25 +488,60 @@ void ECSCoreTemplatePublic::update() {
         }
     }
 
-    TimeProfilerEnd("ECS_Update_Sort");
-
-    TimeProfilerStart("ECS_Update_Execution");
-
-    // Execute levels
-    for (const auto& level : execution_levels) {
+    // Each level starts when the previous one has completed: a sync point joins the systems of a level
+    if (!system_graph) system_graph = std::make_shared<TaskGraph>();
+    system_graph->clear();
+    std::optional<TaskGraph::NodeId> previous_level;
+    for (size_t level_index = 0; level_index < execution_levels.size(); level_index++) {
+        const auto &level = execution_levels[level_index];
         if (level.empty()) continue;
-        
-        for (const auto& sys_id : level) {
-             JobSystem::Get().schedule([this, sys_id]() {
-                auto &sys = systems.at(sys_id);
+
+        const auto level_done = system_graph->addSyncPoint("level " + std::to_string(level_index));
+        for (const auto &sys_id : level) {
+            auto *sys = &systems.at(sys_id);
+            auto job = [this, sys]() {
                 // Pass component_indices to p_func
-                sys.p_func(*this, sys.system_ref, sys.matching_chunk_indices, sys.component_indices);
-             });
+                sys->p_func(*this, sys->system_ref, sys->matching_chunk_indices, sys->component_indices);
+            };
+            size_t thread = JobSystem::ANY_WORKER;
+            if (sys->affinity == SystemAffinity::MainThread) {
+                thread = TaskGraph::CALLER;
+            } else if (sys->affinity == SystemAffinity::DedicatedThread) {
+                thread = sys->dedicated_thread;
+            }
+            const auto node = system_graph->addNode("system " + std::to_string(sys_id), job, thread,
+                                                    JobPriority::Critical);
+            if (previous_level) system_graph->addEdge(*previous_level, node);
+            system_graph->addEdge(node, level_done);
         }
-        
-        JobSystem::Get().wait();
+        previous_level = level_done;
     }
-    
+    system_graph_dirty = false;
+}
+
+void ECSCoreTemplatePublic::update() {
+    global_tick++; 
+    JobSystem::Get().init(); 
+    // workers stay awake for the whole update, levels are short
+    const JobHotPhaseScope hot_phase;
+
+    for (auto channel : event_channels) {
+        channel->swapBuffers();
+    }
+
+    flushPendingAdds();
+    incrementalSort();
+    refreshIndices();
+
+    if (system_graph_dirty) {
+        TimeProfilerStart("ECS_Update_Sort");
+        rebuildSystemGraph();
+        TimeProfilerEnd("ECS_Update_Sort");
+    }
+
+    TimeProfilerStart("ECS_Update_Execution");
+    // main thread systems run here, overlapping with the jobs of their level
+    system_graph->run();
     TimeProfilerEnd("ECS_Update_Execution");
 }
 
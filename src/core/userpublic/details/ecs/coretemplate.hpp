@@ -1,16 +1,22 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <span>
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
 #include <vector>
 #include <functional>
+#include <string>
 #include <tuple>
 
 #include <details/ecs/componentdeclare.hpp>
 #include <details/ecs/chunk.hpp>
+#include <details/ecs/chunkview.hpp>
+#include <details/ecs/event.hpp>
+#include <details/ecs/index.hpp>
+#include <details/ecs/predicate.hpp>
 
 namespace Pelican {
 
@@ -18,14 +24,36 @@ namespace internal {
     size_t getIndexFromComponentId_Ref(ComponentId id);
 }
 
+class MappedFile;
+class TaskGraph;
+
 using SystemId = uint64_t;
+using ObserverId = uint64_t;
 
-template <class... TComponents>
-struct ChunkView {
-    std::tuple<TComponents*...> components;
+// Entities created by one allocateEntity() call, all in the same chunk
+struct EntityBatch {
+    EntityId first;
     size_t count;
 };
 
+enum class SystemAffinity {
+    AnyWorker,       // any job system worker (default)
+    MainThread,      // the thread calling update(); runs while workers process the rest of the level
+    DedicatedThread, // a named thread of its own
+};
+
+enum class ObserverTrigger {
+    OnAdd,    // entities were created (delivered at the beginning of the next update)
+    OnRemove, // an entity is about to be removed (delivered immediately, data is still valid)
+};
+
+// Rows of one chunk affected by a structural event
+template <class... TComponents>
+struct ObserverBatch {
+    std::tuple<TComponents*...> components; // column heads of the chunk
+    std::span<const size_t> rows;
+};
+
 class ECSCoreTemplatePublic {
     // Component Management
   private:
@@ -34,11 +62,13 @@ class ECSCoreTemplatePublic {
 
     std::vector<ECSComponentChunk> chunks_storage;
 
+    static constexpr ChunkIndex INVALID_CHUNK_INDEX = SIZE_MAX;
+
     struct EntityRef {
         ChunkIndex chunk_index;
         WithinChunkIndex array_index;
     };
-    std::vector<EntityRef> id_to_ref;
+    std::vector<EntityRef> id_to_ref; // chunk_index is INVALID_CHUNK_INDEX after removal
 
     struct VectorHash {
         size_t operator()(const std::vector<ComponentId> &v) const {
@@ -50,11 +80,17 @@ class ECSCoreTemplatePublic {
         }
     };
 
-    // Map from sorted component IDs (Archetype) to list of chunk indices
+    // Map from chunk key (sorted component IDs of the archetype followed by the bytes of its shared component
+    // values) to list of chunk indices
     std::unordered_map<std::vector<ComponentId>, std::vector<ChunkIndex>, VectorHash> archetype_to_chunks;
 
   public:
-    EntityId allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs, size_t count);
+    // Allocates up to `count` entities in one chunk and returns how many were created; call again for the rest.
+    // component_ptrs point to the first new row of each component, and new rows are zeroed.
+    // shared_values is parallel to component_ids and gives the value of each shared component (others are ignored,
+    // missing values are zero). Pointers returned for shared components refer to the chunk's value: do not write.
+    EntityBatch allocateEntity(std::span<const ComponentId> component_ids, std::span<void *> component_ptrs, size_t count,
+                            std::span<const void *const> shared_values = {});
     void remove(EntityId id);
     void compaction();
 
@@ -77,12 +113,31 @@ class ECSCoreTemplatePublic {
         std::vector<size_t> write_indices;     // Indices this system writes (T*)
         uint64_t last_run_tick = 0;
         bool force_update = false;
+        SystemAffinity affinity = SystemAffinity::AnyWorker;
+        size_t dedicated_thread = 0;
     };
 
     std::unordered_map<SystemId, InternalSystemWrapper> systems;
     uint64_t system_id_counter = 0;
+    // systems and their dependency levels as a task graph, rebuilt only when systems change
+    std::shared_ptr<TaskGraph> system_graph;
+    bool system_graph_dirty = true;
+
+    void rebuildSystemGraph();
     uint64_t global_tick = 1; // Starts at 1
 
+    // Column pointers starting at `row`; chunk components hold one value and tags have none
+    template <class... TComponents>
+    static std::tuple<TComponents *...> rowTuple(ECSComponentChunk &chunk, const std::vector<size_t> &indices,
+                                                 size_t row) {
+        return [&]<size_t... Is>(std::index_sequence<Is...>) {
+            return std::make_tuple([&]<class T>(T *ptr, size_t index) -> T * {
+                if (ptr == nullptr || chunk.isChunkComponent(index)) return ptr;
+                return ptr + row;
+            }(static_cast<TComponents *>(chunk.getRef(indices[Is]).ptr), indices[Is])...);
+        }(std::make_index_sequence<sizeof...(TComponents)>{});
+    }
+
   public:
     template <class TSystem, class... TComponents>
     SystemId registerSystem(TSystem &system, std::vector<SystemId> &&depends_list, bool force_update = false) {
@@ -153,13 +208,14 @@ class ECSCoreTemplatePublic {
                          if (max_version >= start_last_run_tick) any_change = true;
                      }
 
-                    auto tuple = [&]<size_t... Is>(std::index_sequence<Is...>) {
-                        return std::make_tuple(
-                            static_cast<TComponents *>(chunk.getRef(indices[Is]).ptr)...
-                        );
-                    }(std::make_index_sequence<sizeof...(TComponents)>{});
-                    
-                    views.push_back({tuple, chunk.size()});
+                    if (chunk.allEnabled(indices)) {
+                        views.push_back({rowTuple<TComponents...>(chunk, indices, 0), chunk.size(), &chunk, 0});
+                    } else {
+                        chunk.forEachEnabledRun(indices, [&](size_t begin, size_t end) {
+                            views.push_back(
+                                {rowTuple<TComponents...>(chunk, indices, begin), end - begin, &chunk, begin});
+                        });
+                    }
                 }
                 
                 if (any_change) {
@@ -175,8 +231,19 @@ class ECSCoreTemplatePublic {
                 }
             }
             
-            // 2. Process (Per Chunk)
-            if constexpr (requires { sys.process(std::tuple<TComponents*...>{}, size_t{}); }) {
+            // 2. Process (Per Chunk), as (tuple, count) or as ChunkView
+            constexpr bool per_chunk_tuple = requires { sys.process(std::tuple<TComponents*...>{}, size_t{}); };
+            constexpr bool per_chunk_view = requires { sys.process(ChunkView<TComponents...>{}); };
+            if constexpr (per_chunk_tuple || per_chunk_view) {
+                auto call = [&](ECSComponentChunk &chunk, size_t begin, size_t count) {
+                    if constexpr (per_chunk_tuple) {
+                        sys.process(rowTuple<TComponents...>(chunk, indices, begin), count);
+                    } else {
+                        sys.process(
+                            ChunkView<TComponents...>{rowTuple<TComponents...>(chunk, indices, begin), count, &chunk, begin});
+                    }
+                };
+
                 for (auto chunk_idx : chunks) {
                     auto &chunk = core.chunks_storage[chunk_idx];
                     
@@ -192,13 +259,14 @@ class ECSCoreTemplatePublic {
                          continue; 
                     }
 
-                    auto tuple = [&]<size_t... Is>(std::index_sequence<Is...>) {
-                        return std::make_tuple(
-                            static_cast<TComponents *>(chunk.getRef(indices[Is]).ptr)...
-                        );
-                    }(std::make_index_sequence<sizeof...(TComponents)>{});
-                    
-                    sys.process(tuple, chunk.size());
+                    // Disabled rows are skipped by calling process() per run of enabled rows
+                    if (chunk.allEnabled(indices)) {
+                        call(chunk, 0, chunk.size());
+                    } else {
+                        chunk.forEachEnabledRun(indices, [&](size_t begin, size_t end) {
+                            call(chunk, begin, end - begin);
+                        });
+                    }
                     executed_any = true;
                     
                     for (auto w_idx : sys_wrapper.write_indices) {
@@ -213,6 +281,7 @@ class ECSCoreTemplatePublic {
         };
 
         systems.emplace(id, std::move(wrapper));
+        system_graph_dirty = true;
         
         // Check existing chunks
         for (size_t i = 0; i < chunks_storage.size(); ++i) {
@@ -224,6 +293,154 @@ class ECSCoreTemplatePublic {
         return id;
     }
     void unregisterSystem(SystemId system_id);
+    // thread_name selects the thread for SystemAffinity::DedicatedThread (systems with the same name share it)
+    void setSystemAffinity(SystemId system_id, SystemAffinity affinity, const std::string &thread_name = "");
+
+    // Disabled components hide the entity from systems querying them without moving it to another archetype.
+    // Do not toggle rows of a chunk while a system iterating that chunk is running.
+    void setEnabled(EntityId id, ComponentId component_id, bool enabled);
+    bool isEnabled(EntityId id, ComponentId component_id) const;
+    template <class TComponent> void setEnabled(EntityId id, bool enabled) {
+        setEnabled(id, ComponentIdByType<TComponent>::value, enabled);
+    }
+    template <class TComponent> bool isEnabled(EntityId id) const {
+        return isEnabled(id, ComponentIdByType<TComponent>::value);
+    }
+
+    // Observer Management
+  private:
+    // rows grouped by chunk
+    using RowsByChunk = std::vector<std::pair<ChunkIndex, std::vector<size_t>>>;
+
+    struct InternalObserverWrapper {
+        ObserverId id;
+        ObserverTrigger trigger;
+        ComponentMask matching_mask = 0;
+        std::vector<size_t> component_indices;
+        void *observer_ref;
+        std::function<void(ECSCoreTemplatePublic &, void *, const RowsByChunk &, const std::vector<size_t> &)> p_func;
+    };
+
+    std::unordered_map<ObserverId, InternalObserverWrapper> observers;
+    uint64_t observer_id_counter = 0;
+
+    struct PendingAdd {
+        EntityId first;
+        size_t count;
+    };
+    std::vector<PendingAdd> pending_adds;
+
+    void notifyObservers(ObserverTrigger trigger, const RowsByChunk &rows);
+    void flushPendingAdds();
+
+  public:
+    // TObserver::observe(std::span<ObserverBatch<TComponents...>>) is called once per structural event
+    // on entities which have all of TComponents. Observers run on the thread calling update().
+    // OnAdd is delivered at the start of the next update() to the observers registered at that point, so an
+    // observer registered before that update also sees the entities created since the previous one.
+    // Entities delivered by earlier updates are not replayed.
+    template <class TObserver, class... TComponents>
+    ObserverId registerObserver(TObserver &observer, ObserverTrigger trigger) {
+        ObserverId id = ++observer_id_counter;
+
+        InternalObserverWrapper wrapper;
+        wrapper.id = id;
+        wrapper.trigger = trigger;
+        wrapper.observer_ref = &observer;
+        (
+            [&] {
+                ComponentId cid = ComponentIdByType<typename std::remove_const<TComponents>::type>::value;
+                size_t idx = Pelican::internal::getIndexFromComponentId_Ref(cid);
+                wrapper.component_indices.push_back(idx);
+                wrapper.matching_mask |= (1ULL << idx);
+            }(),
+            ...);
+
+        wrapper.p_func = [](ECSCoreTemplatePublic &core, void *obs_ptr, const RowsByChunk &rows,
+                            const std::vector<size_t> &indices) {
+            TObserver &obs = *static_cast<TObserver *>(obs_ptr);
+
+            std::vector<ObserverBatch<TComponents...>> batches;
+            batches.reserve(rows.size());
+            for (const auto &[chunk_idx, chunk_rows] : rows) {
+                auto &chunk = core.chunks_storage[chunk_idx];
+                auto tuple = [&]<size_t... Is>(std::index_sequence<Is...>) {
+                    return std::make_tuple(static_cast<TComponents *>(chunk.getRef(indices[Is]).ptr)...);
+                }(std::make_index_sequence<sizeof...(TComponents)>{});
+                batches.push_back({tuple, chunk_rows});
+            }
+            if (!batches.empty())
+                obs.observe(std::span<ObserverBatch<TComponents...>>{batches});
+        };
+
+        observers.emplace(id, std::move(wrapper));
+        return id;
+    }
+    void unregisterObserver(ObserverId observer_id);
+
+    // In-archetype Sorting
+  private:
+    struct SortKey {
+        size_t component_index;
+        std::function<uint64_t(const void *)> key;
+    };
+    std::vector<SortKey> sort_keys;
+    size_t sort_budget = 4; // chunk steps per update
+    size_t sort_cursor = 0;
+
+    void setSortKeyRaw(size_t component_index, std::function<uint64_t(const void *)> key);
+    // Reorders rows of chunk a (and b if valid) so that combined row i receives the row order[i]
+    void applyRowOrder(ChunkIndex a, ChunkIndex b, const std::vector<size_t> &order);
+    void sortStep(const SortKey &sort_key, const std::vector<ChunkIndex> &chunks, size_t position);
+    void incrementalSort();
+
+  public:
+    // Rows of every chunk containing TComponent are gradually ordered by key_func(component) (ascending),
+    // both within a chunk and across the chunks of the same archetype. The work is spread over updates,
+    // sort_budget chunk steps per update. EntityIds stay valid; row positions change.
+    // Archetypes with a component which is not trivially copyable are left unsorted.
+    template <class TComponent, class TKeyFunc> void setSortKey(TKeyFunc key_func) {
+        const ComponentId cid = ComponentIdByType<TComponent>::value;
+        setSortKeyRaw(internal::getIndexFromComponentId_Ref(cid), [key_func](const void *c) -> uint64_t {
+            return key_func(*static_cast<const TComponent *>(c));
+        });
+    }
+    void setSortBudget(size_t chunk_steps) { sort_budget = chunk_steps; }
+
+    // Event Management
+  private:
+    std::vector<EventChannelBase *> event_channels;
+
+  public:
+    // Registered channels are flipped at the beginning of every update()
+    void registerEventChannel(EventChannelBase &channel);
+    void unregisterEventChannel(EventChannelBase &channel);
+
+    // Index Management
+  private:
+    std::vector<ComponentIndexBase *> secondary_indices;
+
+    void refreshIndex(ComponentIndexBase &index);
+
+  public:
+    // The index is filled from the current entities and then maintained until unregistered
+    void registerIndex(ComponentIndexBase &index);
+    void unregisterIndex(ComponentIndexBase &index);
+    // Rescans chunks written since the last refresh (done by update()). Not while systems are running.
+    void refreshIndices();
+
+    // World Image
+  private:
+    std::vector<std::shared_ptr<MappedFile>> world_images; // mapped images whose memory chunks still use
+
+  public:
+    // Writes every chunk, the entity table and the archetype map to a binary image.
+    // Component data is stored bytewise: returns false without writing anything when a component is not
+    // relocatable (not trivially copyable, e.g. holds a std::string).
+    bool saveWorldImage(const std::string &path);
+    // Maps an image saved by the same build into an empty world. Chunk columns are used in place
+    // (copy-on-write), and component init() runs again as it does after json loading.
+    void loadWorldImage(const std::string &path);
 
     void update();
 };
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace Pelican {
+
+namespace internal {
+// SIZE_MAX for threads which are neither the main thread nor a job system thread
+size_t getJobThreadIndex();
+size_t getJobThreadSlotCount();
+} // namespace internal
+
+class EventChannelBase {
+  public:
+    virtual ~EventChannelBase() = default;
+
+    // Called by the ECS core at the beginning of every frame, while no system is running
+    virtual void swapBuffers() = 0;
+};
+
+// Typed event stream between systems.
+// Every job thread appends to its own buffer, so send() takes no lock. Events sent during a frame are
+// visible through read() to systems in later execution levels of the same frame, and through
+// readPrevious() during the whole next frame. Event blocks are recycled, so no heap allocation happens
+// once the buffers have grown to the peak event count.
+template <class TEvent> class EventChannel : public EventChannelBase {
+    static_assert(std::is_trivially_copyable_v<TEvent> && std::is_trivially_destructible_v<TEvent>,
+                  "event type must be trivially copyable");
+
+    static constexpr size_t BLOCK_EVENTS = 1024;
+
+    struct Block {
+        alignas(TEvent) std::byte data[sizeof(TEvent) * BLOCK_EVENTS];
+
+        TEvent *at(size_t index) { return reinterpret_cast<TEvent *>(data) + index; }
+        const TEvent *at(size_t index) const { return reinterpret_cast<const TEvent *>(data) + index; }
+    };
+
+    // Written by one thread only; aligned to avoid false sharing between writers
+    struct alignas(64) ThreadBuffer {
+        std::vector<std::unique_ptr<Block>> blocks;
+        size_t count = 0;
+
+        void push(const TEvent &ev) {
+            const size_t block_index = count / BLOCK_EVENTS;
+            if (block_index == blocks.size())
+                blocks.push_back(std::make_unique<Block>());
+            *blocks[block_index]->at(count % BLOCK_EVENTS) = ev;
+            count++;
+        }
+
+        template <class F> void forEach(F &f) const {
+            for (size_t base = 0, b = 0; base < count; base += BLOCK_EVENTS, b++) {
+                const size_t n = count - base < BLOCK_EVENTS ? count - base : BLOCK_EVENTS;
+                const TEvent *events = blocks[b]->at(0);
+                for (size_t i = 0; i < n; i++)
+                    f(events[i]);
+            }
+        }
+    };
+
+    std::vector<ThreadBuffer> buffers[2];
+    size_t write_side = 0;
+
+    // threads without a buffer of their own (outside the job system, or job threads started after the last
+    // swapBuffers(), e.g. everything before the first frame) share this one under a lock
+    std::mutex shared_mutex;
+    ThreadBuffer shared[2];
+
+    void fitThreadCount() {
+        const size_t slots = internal::getJobThreadSlotCount();
+        for (auto &side : buffers) {
+            if (side.size() < slots)
+                side.resize(slots);
+        }
+    }
+
+    template <class F> static void forEachIn(const std::vector<ThreadBuffer> &side, F &f) {
+        for (const auto &buf : side)
+            buf.forEach(f);
+    }
+
+    static size_t countIn(const std::vector<ThreadBuffer> &side) {
+        size_t n = 0;
+        for (const auto &buf : side)
+            n += buf.count;
+        return n;
+    }
+
+  public:
+    // Safe to call concurrently from any thread; lock free on the main thread and job threads
+    void send(const TEvent &ev) {
+        const size_t slot = internal::getJobThreadIndex();
+        auto &side = buffers[write_side];
+        if (slot < side.size()) {
+            side[slot].push(ev);
+        } else {
+            std::lock_guard<std::mutex> lock(shared_mutex);
+            shared[write_side].push(ev);
+        }
+    }
+
+    // Events sent in this frame so far. Only call from levels after the writers.
+    template <class F> void read(F &&f) const {
+        forEachIn(buffers[write_side], f);
+        shared[write_side].forEach(f);
+    }
+    size_t size() const { return countIn(buffers[write_side]) + shared[write_side].count; }
+
+    // Events sent in the previous frame
+    template <class F> void readPrevious(F &&f) const {
+        forEachIn(buffers[write_side ^ 1], f);
+        shared[write_side ^ 1].forEach(f);
+    }
+    size_t previousSize() const { return countIn(buffers[write_side ^ 1]) + shared[write_side ^ 1].count; }
+
+    void swapBuffers() override {
+        write_side ^= 1;
+        fitThreadCount();
+        for (auto &buf : buffers[write_side])
+            buf.count = 0;
+        shared[write_side].count = 0;
+    }
+};
+
+} // namespace Pelican
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <details/ecs/chunk.hpp>
+#include <details/ecs/componentdeclare.hpp>
+
+namespace Pelican {
+
+namespace internal {
+size_t getIndexFromComponentId_Ref(ComponentId id);
+}
+
+// Secondary index over a component, kept up to date by the ECS core.
+// Chunks are rescanned at the beginning of update() when they were written since the last scan (or grew),
+// and removed entities are dropped immediately. Lookups therefore reflect the state at the beginning of
+// the current update; call ECSCore::refreshIndices() to catch up while no system is running.
+class ComponentIndexBase {
+    size_t component_index;
+    std::unordered_map<uint64_t, uint64_t> scanned_write_counts; // by chunk serial
+
+  protected:
+    virtual void scanChunk(const ECSComponentChunk &chunk, const EntityId *entity_ids) = 0;
+
+  public:
+    ComponentIndexBase(size_t _component_index) : component_index{_component_index} {}
+    virtual ~ComponentIndexBase() = default;
+
+    size_t getComponentIndex() const { return component_index; }
+
+    void refresh(const ECSComponentChunk &chunk, const EntityId *entity_ids) {
+        const uint64_t write_count = chunk.getWriteCount(component_index);
+        auto [it, inserted] = scanned_write_counts.try_emplace(chunk.getSerial(), write_count);
+        if (!inserted && it->second == write_count)
+            return;
+        it->second = write_count;
+        scanChunk(chunk, entity_ids);
+    }
+
+    virtual void erase(EntityId id) = 0;
+};
+
+// Index keyed by key_func(component); TComponent must be a per-entity component
+template <class TComponent, class TKey> class KeyedComponentIndex : public ComponentIndexBase {
+    static_assert(ComponentStorageByType<TComponent>::value == ComponentStorage::Column,
+                  "only per-entity components can be indexed");
+
+    std::function<TKey(const TComponent &)> key_func;
+
+  protected:
+    virtual void set(EntityId id, const TKey &key) = 0;
+
+    void scanChunk(const ECSComponentChunk &chunk, const EntityId *entity_ids) override {
+        const auto *rows = static_cast<const TComponent *>(chunk.getData(getComponentIndex()));
+        for (size_t i = 0; i < chunk.size(); i++)
+            set(entity_ids[i], key_func(rows[i]));
+    }
+
+  public:
+    template <class TKeyFunc>
+    KeyedComponentIndex(TKeyFunc _key_func)
+        : ComponentIndexBase{internal::getIndexFromComponentId_Ref(ComponentIdByType<TComponent>::value)},
+          key_func{std::move(_key_func)} {}
+    KeyedComponentIndex(TKey TComponent::*field)
+        : KeyedComponentIndex{[field](const TComponent &c) { return c.*field; }} {}
+};
+
+// Point lookups in O(1), e.g. "the player with id X", "all units of team 3"
+template <class TComponent, class TKey, class THash = std::hash<TKey>>
+class HashComponentIndex : public KeyedComponentIndex<TComponent, TKey> {
+    struct Entry {
+        TKey key;
+        size_t slot; // position in the bucket
+    };
+    std::unordered_map<EntityId, Entry> entries;
+    std::unordered_map<TKey, std::vector<EntityId>, THash> buckets;
+
+    void unlink(const Entry entry) {
+        auto bucket = buckets.find(entry.key);
+        const EntityId last = bucket->second.back();
+        bucket->second[entry.slot] = last;
+        entries[last].slot = entry.slot;
+        bucket->second.pop_back();
+        if (bucket->second.empty())
+            buckets.erase(bucket);
+    }
+
+  protected:
+    void set(EntityId id, const TKey &key) override {
+        auto [it, inserted] = entries.try_emplace(id, Entry{key, 0});
+        if (!inserted) {
+            if (it->second.key == key)
+                return;
+            unlink(it->second);
+            it->second.key = key;
+        }
+        auto &bucket = buckets[key];
+        it->second.slot = bucket.size();
+        bucket.push_back(id);
+    }
+
+  public:
+    using KeyedComponentIndex<TComponent, TKey>::KeyedComponentIndex;
+
+    void erase(EntityId id) override {
+        auto it = entries.find(id);
+        if (it == entries.end())
+            return;
+        unlink(it->second);
+        entries.erase(it);
+    }
+
+    // Entities whose key equals `key`, in no particular order. Invalidated by the next refresh.
+    std::span<const EntityId> find(const TKey &key) const {
+        auto it = buckets.find(key);
+        if (it == buckets.end())
+            return {};
+        return it->second;
+    }
+    size_t count(const TKey &key) const { return find(key).size(); }
+    size_t size() const { return entries.size(); }
+};
+
+// Point and range lookups in O(log n), e.g. "all entities in grid cells [a, b]"
+template <class TComponent, class TKey, class TCompare = std::less<TKey>>
+class OrderedComponentIndex : public KeyedComponentIndex<TComponent, TKey> {
+    using Map = std::multimap<TKey, EntityId, TCompare>;
+    Map ordered;
+    std::unordered_map<EntityId, typename Map::iterator> entries;
+
+  protected:
+    void set(EntityId id, const TKey &key) override {
+        auto it = entries.find(id);
+        if (it != entries.end()) {
+            const auto &old_key = it->second->first;
+            if (!ordered.key_comp()(old_key, key) && !ordered.key_comp()(key, old_key))
+                return;
+            ordered.erase(it->second);
+            it->second = ordered.emplace(key, id);
+        } else {
+            entries.emplace(id, ordered.emplace(key, id));
+        }
+    }
+
+  public:
+    using KeyedComponentIndex<TComponent, TKey>::KeyedComponentIndex;
+
+    void erase(EntityId id) override {
+        auto it = entries.find(id);
+        if (it == entries.end())
+            return;
+        ordered.erase(it->second);
+        entries.erase(it);
+    }
+
+    // Calls f(key, id) for every entity with lo <= key <= hi, in key order
+    template <class F> void forEachInRange(const TKey &lo, const TKey &hi, F &&f) const {
+        for (auto it = ordered.lower_bound(lo), end = ordered.upper_bound(hi); it != end; ++it)
+            f(it->first, it->second);
+    }
+
+    void findRange(const TKey &lo, const TKey &hi, std::vector<EntityId> &out) const {
+        out.clear();
+        forEachInRange(lo, hi, [&](const TKey &, EntityId id) { out.push_back(id); });
+    }
+    void find(const TKey &key, std::vector<EntityId> &out) const { findRange(key, key, out); }
+
+    size_t count(const TKey &key) const { return ordered.count(key); }
+    size_t size() const { return entries.size(); }
+};
+
+} // namespace Pelican
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <details/ecs/chunk.hpp>
+#include <details/ecs/chunkview.hpp>
+
+namespace Pelican {
+
+namespace internal {
+size_t getIndexFromComponentId_Ref(ComponentId id);
+}
+
+// Rows of a ChunkView selected by a predicate, one bit per row
+class RowMask {
+    std::vector<uint64_t> words;
+    size_t count = 0;
+
+  public:
+    void reset(size_t row_count) {
+        count = row_count;
+        words.assign((row_count + 63) / 64, 0);
+    }
+
+    size_t size() const { return count; }
+    std::span<uint64_t> data() { return words; }
+    std::span<const uint64_t> data() const { return words; }
+
+    bool test(size_t row) const { return words[row / 64] >> (row % 64) & 1; }
+
+    bool any() const {
+        for (auto w : words) {
+            if (w != 0) return true;
+        }
+        return false;
+    }
+
+    size_t popcount() const {
+        size_t n = 0;
+        for (auto w : words)
+            n += std::popcount(w);
+        return n;
+    }
+
+    // Calls f(row) for every selected row, in ascending order
+    template <class F> void forEach(F &&f) const {
+        for (size_t w = 0; w < words.size(); w++) {
+            for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1)
+                f(w * 64 + std::countr_zero(bits));
+        }
+    }
+
+    // Compact list of the selected rows
+    void toIndices(std::vector<uint32_t> &out) const {
+        out.clear();
+        out.reserve(popcount());
+        forEach([&](size_t row) { out.push_back(static_cast<uint32_t>(row)); });
+    }
+};
+
+// Evaluates pred(column[i]) for every row into mask.
+// Rows are handled in blocks of 64: the predicate results go to a byte array first and are packed into
+// a mask word afterwards, so both loops are branch free and can be vectorized by the compiler.
+template <class T, class TPred> void selectRows(std::span<T> column, TPred &&pred, RowMask &mask) {
+    mask.reset(column.size());
+    auto words = mask.data();
+    const T *PELICAN_RESTRICT values = column.data();
+
+    for (size_t base = 0; base < column.size(); base += 64) {
+        const size_t n = std::min<size_t>(64, column.size() - base);
+        uint8_t flags[64];
+        for (size_t j = 0; j < n; j++)
+            flags[j] = pred(values[base + j]) ? 1 : 0;
+
+        uint64_t word = 0;
+        for (size_t j = 0; j < n; j++)
+            word |= static_cast<uint64_t>(flags[j]) << j;
+        words[base / 64] = word;
+    }
+}
+
+enum class CompareOp { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+// Selects rows by comparing one scalar field of a component with a constant, e.g.
+//   FieldQuery<HealthComponent, float> dead{&HealthComponent::hp};
+//   if (dead.select(chunk, CompareOp::LessEqual, 0.0f, mask)) mask.forEach(...);
+// The min/max of the field is kept per chunk, so chunks which can't contain a match are skipped without
+// touching their rows. A summary is recomputed only after a system with write access to the component
+// ran on the chunk (or rows were added or sorted into it). Removing rows keeps the summary, which then stays a
+// conservative bound. Not thread safe: use one instance per system.
+// Writes the core doesn't see are not picked up: values changed through pointers kept outside a system, or
+// by the querying system itself between two selects of the same run (the write is recorded after the system
+// finished the chunk). Call invalidate() after such writes.
+template <class TComponent, class TField> class FieldQuery {
+    static_assert(std::is_arithmetic_v<TField>, "only scalar fields can be summarized");
+
+    struct Summary {
+        uint64_t write_count;
+        uint64_t row_exchanges;
+        uint64_t last_used; // select_count when last read
+        TField min;         // of the non-NaN values
+        TField max;
+        bool has_value;     // false when every value is NaN: min/max are meaningless then
+        bool has_nan;
+    };
+
+    // summaries unused for this many selects are dropped (e.g. chunks of an unloaded world)
+    static constexpr uint64_t EVICT_AFTER_SELECTS = 4096;
+
+    TField TComponent::*field;
+    size_t component_index;
+    std::unordered_map<uint64_t, Summary> summaries; // by chunk serial
+    uint64_t select_count = 0;
+
+    // nullptr for an empty chunk
+    const Summary *summaryOf(const ECSComponentChunk &chunk) {
+        if (chunk.size() == 0)
+            return nullptr;
+        const uint64_t write_count = chunk.getWriteCount(component_index);
+        const uint64_t row_exchanges = chunk.getRowExchanges();
+        auto [it, inserted] = summaries.try_emplace(chunk.getSerial());
+        Summary &s = it->second;
+        s.last_used = select_count;
+        if (!inserted && s.write_count == write_count && s.row_exchanges == row_exchanges)
+            return &s;
+
+        const auto *rows = static_cast<const TComponent *>(chunk.getData(component_index));
+        // NaN compares false with everything, so it would stick as the seed or be skipped by the fold
+        // depending on where it is. It's kept out of min/max and only remembered.
+        size_t first = 0;
+        if constexpr (std::is_floating_point_v<TField>) {
+            while (first < chunk.size() && std::isnan(rows[first].*field))
+                first++;
+        }
+        bool has_nan = first != 0;
+        TField lo{};
+        TField hi{};
+        if (first < chunk.size()) {
+            lo = rows[first].*field;
+            hi = lo;
+        }
+        for (size_t i = first + 1; i < chunk.size(); i++) {
+            const TField v = rows[i].*field;
+            if constexpr (std::is_floating_point_v<TField>) {
+                if (std::isnan(v)) {
+                    has_nan = true;
+                    continue;
+                }
+            }
+            lo = v < lo ? v : lo;
+            hi = v > hi ? v : hi;
+        }
+        s = Summary{write_count, row_exchanges, select_count, lo, hi, first < chunk.size(), has_nan};
+        return &s;
+    }
+
+    void evictUnused() {
+        std::erase_if(summaries, [&](const auto &entry) {
+            return select_count - entry.second.last_used >= EVICT_AFTER_SELECTS;
+        });
+    }
+
+    // Whether any row summarized by s can satisfy `v op value`. A NaN row only matches NotEqual.
+    static bool mayMatch(const Summary &s, CompareOp op, TField value) {
+        if (op == CompareOp::NotEqual && s.has_nan)
+            return true;
+        if (!s.has_value)
+            return false;
+        const TField lo = s.min;
+        const TField hi = s.max;
+        switch (op) {
+        case CompareOp::Less: return lo < value;
+        case CompareOp::LessEqual: return lo <= value;
+        case CompareOp::Greater: return hi > value;
+        case CompareOp::GreaterEqual: return hi >= value;
+        case CompareOp::Equal: return lo <= value && value <= hi;
+        case CompareOp::NotEqual: return !(lo == value && hi == value);
+        }
+        return true;
+    }
+
+    template <class TOp> void evaluate(std::span<const TComponent> rows, TField value, TOp op, RowMask &mask) {
+        const auto f = field;
+        selectRows(rows, [=](const TComponent &c) { return op(c.*f, value); }, mask);
+    }
+
+  public:
+    FieldQuery(TField TComponent::*_field)
+        : field{_field},
+          component_index{internal::getIndexFromComponentId_Ref(
+              ComponentIdByType<std::remove_const_t<TComponent>>::value)} {}
+
+    // Fills mask with the rows of the view matching `field op value`.
+    // Returns false (and leaves mask empty) when no row matches.
+    template <class... TComponents>
+    bool select(const ChunkView<TComponents...> &view, CompareOp op, TField value, RowMask &mask) {
+        static_assert(internal::storageOf<TComponent> == ComponentStorage::Column,
+                      "field queries need a per-entity component");
+        if (++select_count % EVICT_AFTER_SELECTS == 0)
+            evictUnused();
+        if (view.count == 0) {
+            mask.reset(0);
+            return false;
+        }
+        if (view.chunk != nullptr) {
+            const Summary *s = summaryOf(*view.chunk);
+            if (s == nullptr || !mayMatch(*s, op, value)) {
+                mask.reset(0);
+                return false;
+            }
+        }
+
+        // Dispatch once per chunk so the inner loop compares with a fixed operator
+        const TComponent *base;
+        if constexpr ((std::is_same_v<TComponents, const TComponent> || ...)) {
+            base = std::get<const TComponent *>(view.components);
+        } else {
+            base = std::get<TComponent *>(view.components);
+        }
+        std::span<const TComponent> rows{base, view.count};
+        switch (op) {
+        case CompareOp::Less: evaluate(rows, value, std::less<TField>{}, mask); break;
+        case CompareOp::LessEqual: evaluate(rows, value, std::less_equal<TField>{}, mask); break;
+        case CompareOp::Greater: evaluate(rows, value, std::greater<TField>{}, mask); break;
+        case CompareOp::GreaterEqual: evaluate(rows, value, std::greater_equal<TField>{}, mask); break;
+        case CompareOp::Equal: evaluate(rows, value, std::equal_to<TField>{}, mask); break;
+        case CompareOp::NotEqual: evaluate(rows, value, std::not_equal_to<TField>{}, mask); break;
+        }
+        return mask.any();
+    }
+
+    // Forget every summary, e.g. after writes the core doesn't track
+    void invalidate() { summaries.clear(); }
+    void invalidate(const ECSComponentChunk &chunk) { summaries.erase(chunk.getSerial()); }
+};
+
+} // namespace Pelican
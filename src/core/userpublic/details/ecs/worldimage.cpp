@@ -0,0 +1,273 @@
+#include "coretemplate.hpp"
+#include "../../../container.hpp"
+#include "../../../ecs/componentinfo.hpp"
+#include "../../../os/mappedfile.hpp"
+#include "../../../profiler.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace Pelican {
+
+namespace {
+
+// World image layout. Every reference is a byte offset from the beginning of the file, so the image can be
+// mapped at any address; columns are 64 byte aligned and used in place.
+constexpr char WORLD_IMAGE_MAGIC[8] = {'P', 'E', 'L', 'W', 'O', 'R', 'L', 'D'};
+constexpr uint32_t WORLD_IMAGE_VERSION = 1;
+constexpr uint32_t WORLD_IMAGE_BYTE_ORDER = 0x01020304;
+constexpr size_t WORLD_IMAGE_ALIGN = 64;
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint64_t chunk_count;
+    uint64_t chunks_offset; // ImageChunk[chunk_count]
+    uint64_t entity_count;
+    uint64_t entities_offset; // ImageEntityRef[entity_count]
+};
+
+struct ImageChunk {
+    uint64_t row_count;
+    uint64_t column_count;
+    uint64_t columns_offset; // ImageColumn[column_count], in the order of the chunk's components
+    uint64_t key_size;       // archetype key length in ComponentIds
+    uint64_t key_offset;
+};
+
+struct ImageColumn {
+    ComponentId component_id;
+    uint64_t storage;
+    uint64_t stride;
+    uint64_t data_offset; // 0 for tags
+    uint64_t enable_word_count;
+    uint64_t enable_words_offset;
+};
+
+struct ImageEntityRef {
+    uint64_t chunk_index;
+    uint64_t array_index;
+};
+
+class ImageWriter {
+    std::vector<uint8_t> buf;
+
+  public:
+    uint64_t reserve(size_t size, size_t align = alignof(uint64_t)) {
+        const size_t offset = (buf.size() + align - 1) / align * align;
+        buf.resize(offset + size, 0);
+        return offset;
+    }
+    uint64_t append(const void *data, size_t size, size_t align = alignof(uint64_t)) {
+        const auto offset = reserve(size, align);
+        if (size != 0) std::memcpy(buf.data() + offset, data, size);
+        return offset;
+    }
+    template <class T> void put(uint64_t offset, const T &value) { std::memcpy(buf.data() + offset, &value, sizeof(T)); }
+    const std::vector<uint8_t> &data() const { return buf; }
+};
+
+// Bounds checked view of a mapped image
+struct ImageReader {
+    uint8_t *base;
+    size_t size;
+
+    template <class T> T *at(uint64_t offset, uint64_t count = 1) const {
+        if (offset > size || count > (size - offset) / sizeof(T) || offset % alignof(T) != 0)
+            throw std::runtime_error("world image is corrupted");
+        return reinterpret_cast<T *>(base + offset);
+    }
+};
+
+} // namespace
+
+bool ECSCoreTemplatePublic::saveWorldImage(const std::string &path) {
+    auto &mgr = GET_MODULE(ComponentInfoManager);
+    for (const auto &chunk : chunks_storage) {
+        for (const auto idx : chunk.getIndices()) {
+            if (chunk.getStorage(idx) != ComponentStorage::Tag && !mgr.isRelocatableFromIndex(idx))
+                return false;
+        }
+    }
+
+    TimeProfilerStart("ECS_SaveWorldImage");
+
+    std::vector<const std::vector<ComponentId> *> chunk_keys(chunks_storage.size(), nullptr);
+    for (const auto &[key, chunk_indices] : archetype_to_chunks) {
+        for (auto chunk_index : chunk_indices)
+            chunk_keys[chunk_index] = &key;
+    }
+
+    ImageWriter w;
+    const auto header_offset = w.reserve(sizeof(ImageHeader));
+    const auto chunks_offset = w.reserve(sizeof(ImageChunk) * chunks_storage.size());
+
+    for (size_t c = 0; c < chunks_storage.size(); c++) {
+        auto &chunk = chunks_storage[c];
+        const auto chunk_indices = chunk.getIndices();
+        const auto chunk_ids = chunk.getComponentList();
+
+        const auto columns_offset = w.reserve(sizeof(ImageColumn) * chunk_indices.size());
+        const auto &key = *chunk_keys[c];
+        const auto key_offset = w.append(key.data(), key.size() * sizeof(ComponentId));
+
+        for (size_t i = 0; i < chunk_indices.size(); i++) {
+            const auto idx = chunk_indices[i];
+            const auto storage = chunk.getStorage(idx);
+            const auto ref = chunk.getRef(idx);
+            const size_t rows = chunk.isChunkComponent(idx) ? 1 : chunk.size();
+            const auto enable_words = chunk.getEnableWords(idx);
+
+            ImageColumn column{
+                .component_id = chunk_ids[i],
+                .storage = static_cast<uint64_t>(storage),
+                .stride = ref.stride,
+                .data_offset = ref.ptr ? w.append(ref.ptr, ref.stride * rows, WORLD_IMAGE_ALIGN) : 0,
+                .enable_word_count = enable_words.size(),
+                .enable_words_offset = w.append(enable_words.data(), enable_words.size_bytes()),
+            };
+            w.put(columns_offset + sizeof(ImageColumn) * i, column);
+        }
+
+        w.put(chunks_offset + sizeof(ImageChunk) * c, ImageChunk{
+                                                          .row_count = chunk.size(),
+                                                          .column_count = chunk_indices.size(),
+                                                          .columns_offset = columns_offset,
+                                                          .key_size = key.size(),
+                                                          .key_offset = key_offset,
+                                                      });
+    }
+
+    std::vector<ImageEntityRef> entity_refs(id_to_ref.size());
+    for (size_t i = 0; i < id_to_ref.size(); i++)
+        entity_refs[i] = {id_to_ref[i].chunk_index, id_to_ref[i].array_index};
+    const auto entities_offset = w.append(entity_refs.data(), entity_refs.size() * sizeof(ImageEntityRef));
+
+    ImageHeader header{
+        .version = WORLD_IMAGE_VERSION,
+        .byte_order = WORLD_IMAGE_BYTE_ORDER,
+        .file_size = w.data().size(),
+        .chunk_count = chunks_storage.size(),
+        .chunks_offset = chunks_offset,
+        .entity_count = entity_refs.size(),
+        .entities_offset = entities_offset,
+    };
+    std::memcpy(header.magic, WORLD_IMAGE_MAGIC, sizeof(header.magic));
+    w.put(header_offset, header);
+
+    std::ofstream f{path, std::ios_base::binary | std::ios_base::trunc};
+    f.write(reinterpret_cast<const char *>(w.data().data()), w.data().size());
+    if (!f)
+        throw std::runtime_error("failed to write world image : " + path);
+
+    TimeProfilerEnd("ECS_SaveWorldImage");
+    return true;
+}
+
+void ECSCoreTemplatePublic::loadWorldImage(const std::string &path) {
+    if (!chunks_storage.empty() || !id_to_ref.empty())
+        throw std::runtime_error("world image can only be loaded into an empty world");
+
+    TimeProfilerStart("ECS_LoadWorldImage");
+
+    auto image = std::make_shared<MappedFile>(path);
+    const ImageReader r{image->data(), image->size()};
+
+    const auto &header = *r.at<ImageHeader>(0);
+    if (std::memcmp(header.magic, WORLD_IMAGE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != WORLD_IMAGE_VERSION || header.byte_order != WORLD_IMAGE_BYTE_ORDER ||
+        header.file_size != image->size())
+        throw std::runtime_error("incompatible world image : " + path);
+
+    auto &mgr = GET_MODULE(ComponentInfoManager);
+    const auto *chunks = r.at<ImageChunk>(header.chunks_offset, header.chunk_count);
+
+    const auto *entity_refs = r.at<ImageEntityRef>(header.entities_offset, header.entity_count);
+    for (size_t i = 0; i < header.entity_count; i++) {
+        const auto &ref = entity_refs[i];
+        if (ref.chunk_index == INVALID_CHUNK_INDEX)
+            continue;
+        if (ref.chunk_index >= header.chunk_count || ref.array_index >= chunks[ref.chunk_index].row_count)
+            throw std::runtime_error("incompatible world image : " + path);
+    }
+
+    chunks_storage.reserve(header.chunk_count);
+    for (size_t c = 0; c < header.chunk_count; c++) {
+        const auto &image_chunk = chunks[c];
+        if (image_chunk.column_count > MAX_COMPONENTS)
+            throw std::runtime_error("incompatible world image : " + path);
+        const auto *columns = r.at<ImageColumn>(image_chunk.columns_offset, image_chunk.column_count);
+
+        std::vector<size_t> chunk_indices(image_chunk.column_count);
+        std::vector<ComponentId> chunk_ids(image_chunk.column_count);
+        std::vector<uint8_t *> column_data(image_chunk.column_count, nullptr);
+        for (size_t i = 0; i < image_chunk.column_count; i++) {
+            const auto &column = columns[i];
+            if (!mgr.isRegistered(column.component_id))
+                throw std::runtime_error("incompatible world image : " + path);
+            const auto idx = mgr.getIndexFromComponentId(column.component_id);
+            const auto storage = static_cast<ComponentStorage>(column.storage);
+            if (mgr.getStorageFromIndex(idx) != storage ||
+                (storage != ComponentStorage::Tag && mgr.getSizeFromIndex(idx) != column.stride))
+                throw std::runtime_error("component layout changed since the world image was saved : " + path);
+            if (storage != ComponentStorage::Tag && !mgr.isRelocatableFromIndex(idx))
+                throw std::runtime_error("world image contains a component which is no longer relocatable : " + path);
+
+            chunk_indices[i] = idx;
+            chunk_ids[i] = column.component_id;
+        }
+
+        const ChunkIndex chunk_index = chunks_storage.size();
+        auto &chunk = chunks_storage.emplace_back(std::span<const size_t>(chunk_indices),
+                                                  std::span<const ComponentId>(chunk_ids), false);
+        if (image_chunk.row_count > chunk.capacity())
+            throw std::runtime_error("incompatible world image : " + path);
+        for (size_t i = 0; i < image_chunk.column_count; i++) {
+            const auto &column = columns[i];
+            // enable words are only saved for columns with disabled rows
+            if (column.enable_word_count != 0 && column.enable_word_count != (image_chunk.row_count + 63) / 64)
+                throw std::runtime_error("incompatible world image : " + path);
+            const auto storage = static_cast<ComponentStorage>(column.storage);
+            if (storage != ComponentStorage::Tag) {
+                const bool single = storage == ComponentStorage::Chunk || storage == ComponentStorage::Shared;
+                column_data[i] = r.at<uint8_t>(column.data_offset, column.stride * (single ? 1 : image_chunk.row_count));
+            }
+        }
+        chunk.attach(image_chunk.row_count, column_data);
+
+        for (size_t i = 0; i < image_chunk.column_count; i++) {
+            const auto &column = columns[i];
+            if (column.enable_word_count != 0)
+                chunk.restoreEnableWords(chunk_indices[i], std::span<const uint64_t>(r.at<uint64_t>(
+                                                               column.enable_words_offset, column.enable_word_count),
+                                                           column.enable_word_count));
+            chunk.updateVersion(chunk_indices[i], global_tick);
+
+            // runtime state is rebuilt the same way as after loading from json
+            if (column_data[i] && static_cast<ComponentStorage>(column.storage) != ComponentStorage::Shared) {
+                const size_t rows = chunk.isChunkComponent(chunk_indices[i]) ? 1 : chunk.size();
+                mgr.initComponents(column.component_id, column_data[i], rows);
+            }
+        }
+
+        const auto *key = r.at<ComponentId>(image_chunk.key_offset, image_chunk.key_size);
+        archetype_to_chunks[std::vector<ComponentId>(key, key + image_chunk.key_size)].push_back(chunk_index);
+        updateSystemChunkCache(chunk_index);
+    }
+
+    id_to_ref.resize(header.entity_count);
+    for (size_t i = 0; i < header.entity_count; i++)
+        id_to_ref[i] = {entity_refs[i].chunk_index, entity_refs[i].array_index};
+
+    if (!id_to_ref.empty())
+        pending_adds.push_back({0, id_to_ref.size()});
+
+    world_images.push_back(std::move(image));
+
+    TimeProfilerEnd("ECS_LoadWorldImage");
+}
+
+} // namespace Pelican
@@ -4,12 +4,20 @@
 
 namespace Pelican {
 
-GameObjectId GameObjects::alloc(const ComponentId *ids, void **ptrs, uint32_t components_count) {
-    return GET_MODULE(ECSCore).allocateEntity(std::span{ids, components_count}, std::span{ptrs, components_count}, 1);
+GameObjectId GameObjects::alloc(const ComponentId *ids, void **ptrs, const void *const *shared_values,
+                                uint32_t components_count) {
+    return GET_MODULE(ECSCore)
+        .allocateEntity(std::span{ids, components_count}, std::span{ptrs, components_count}, 1,
+                        std::span{shared_values, shared_values ? components_count : 0})
+        .first;
 }
 void GameObjects::commit(const ComponentId *ids, void *const *ptrs, uint32_t components_count) {
+    auto &mgr = GET_MODULE(ComponentInfoManager);
     for (int i = 0; i < components_count; i++) {
-        GET_MODULE(ComponentInfoManager).initComponent(ids[i], ptrs[i]);
+        // chunk components are initialised once when their chunk is created
+        if (mgr.getStorageFromIndex(mgr.getIndexFromComponentId(ids[i])) == ComponentStorage::Chunk)
+            continue;
+        mgr.initComponents(ids[i], ptrs[i], 1);
     }
 }
 
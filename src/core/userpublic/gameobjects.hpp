@@ -45,7 +45,8 @@ class GameObjects {
         static constexpr size_t value = Indices::first;
     };
 
-    static GameObjectId alloc(const ComponentId *ids, void **ptrs, uint32_t components_count);
+    static GameObjectId alloc(const ComponentId *ids, void **ptrs, const void *const *shared_values,
+                              uint32_t components_count);
     static void commit(const ComponentId *ids, void *const *ptrs, uint32_t components_count);
 
     template <class Indices, class Tuple, size_t... Seq>
@@ -53,7 +54,21 @@ class GameObjects {
         (([&]() {
              using TComponent = std::remove_cvref_t<std::tuple_element_t<Seq, Tuple>>;
              constexpr size_t i = IndicesAt<Indices, Seq>::value;
-             *static_cast<TComponent *>(ptrs[i]) = std::get<Seq>(t);
+             // tags have no storage, shared values are passed on allocation, chunk values belong to the chunk
+             constexpr auto storage = ComponentStorageByType<TComponent>::value;
+             if constexpr (storage == ComponentStorage::Column)
+                 *static_cast<TComponent *>(ptrs[i]) = std::get<Seq>(t);
+         })(),
+         ...);
+    }
+
+    template <class Indices, class Tuple, size_t... Seq>
+    static void collectShared(const void **shared_values, const Tuple &t, Indices indices, std::index_sequence<Seq...>) {
+        (([&]() {
+             using TComponent = std::remove_cvref_t<std::tuple_element_t<Seq, Tuple>>;
+             constexpr size_t i = IndicesAt<Indices, Seq>::value;
+             if constexpr (ComponentStorageByType<TComponent>::value == ComponentStorage::Shared)
+                 shared_values[i] = &std::get<Seq>(t);
          })(),
          ...);
     }
@@ -74,7 +89,10 @@ class GameObjects {
         void finish() {
             auto ids = ComponentIds::ids();
             void *ptrs[ComponentIds::len];
-            GameObjects::alloc(ids.data(), ptrs, std::size(ptrs));
+            const void *shared_values[ComponentIds::len] = {};
+            GameObjects::collectShared(shared_values, data, DataComponentIndices{},
+                                       std::make_index_sequence<std::tuple_size<ComponentDataTuple>::value>());
+            GameObjects::alloc(ids.data(), ptrs, shared_values, std::size(ptrs));
             GameObjects::copy(ptrs, data, DataComponentIndices{},
                               std::make_index_sequence<std::tuple_size<ComponentDataTuple>::value>());
             GameObjects::commit(ids.data(), ptrs, std::size(ptrs));
@@ -94,7 +112,7 @@ class GameObjects {
         void finish() {
             auto ids = ComponentIds::ids();
             void *ptrs[ComponentIds::len];
-            GameObjects::alloc(ids.data(), ptrs, std::size(ptrs));
+            GameObjects::alloc(ids.data(), ptrs, nullptr, std::size(ptrs));
             GameObjects::commit(ids.data(), ptrs, std::size(ptrs));
         };
     };
@@ -1,5 +1,6 @@
 #include "pelican_core.hpp"
 #include "../appflow/loop.hpp"
+#include "../job_system.hpp"
 #include "../log.hpp"
 #include "../vkcore/core.hpp"
 
@@ -24,6 +25,8 @@ void PelicanCore::run() {
     try {
         FastModuleContainer container;
         GET_MODULE(ProjectSource).setSourceByData(settings_str);
+        // before anything schedules a job, which would start the workers with the default settings
+        JobSystem::Get().init(GET_MODULE(ProjectBasicConfig).jobSystemConfig());
 
         GET_MODULE(ECSPredefinedRegistration).reg();
         GET_MODULE(SceneLoader).load(GET_MODULE(ProjectBasicConfig).defaultSceneId());
@@ -16,26 +16,23 @@ DECLARE_COMPONENT(MyCharComponent, 32);
 
 class MyCharSystem {
   public:
-    using QueryComponents = std::tuple<MyCharComponent *, Pelican::LocalTransformComponent *>;
+    using Query = Pelican::ChunkView<MyCharComponent, Pelican::LocalTransformComponent>;
     int timer = 0;
 
-    void process(QueryComponents components, size_t count) {
-        auto m = std::get<MyCharComponent *>(components);
-        auto t = std::get<Pelican::LocalTransformComponent *>(components);
+    void process(Query chunk) {
+        chunk.each([](MyCharComponent &m, Pelican::LocalTransformComponent &t) {
+            t.pos = Pelican::vec3{m.x, 0, 0};
+            t.scale = Pelican::vec3{0.1, 0.1, 0.1};
+            t.rotation = Pelican::quat{0, 0, 0, 1};
 
-        for (int i = 0; i < count; i++) {
-            t[i].pos = Pelican::vec3{m[i].x, 0, 0};
-            t[i].scale = Pelican::vec3{0.1, 0.1, 0.1};
-            t[i].rotation = Pelican::quat{0, 0, 0, 1};
-
-            m[i].x += 0.05;
-        }
+            m.x += 0.05;
+        });
 
         // timer++;
         // if (timer == 10)
         //     Pelican::GameObjects::add()
         //         .addComponent<Pelican::TransformComponent>()
-        //         .addComponent<Pelican::LocalTransformComponent>(t[0])
+        //         .addComponent<Pelican::LocalTransformComponent>(chunk.column<1>()[0])
         //         .addComponent<Pelican::SimpleModelViewComponent>()
         //         .finish();
     }
@@ -0,0 +1,89 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "ecs/componentinfo.hpp"
+#include <details/ecs/chunk.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace Pelican {
+
+namespace {
+
+constexpr ComponentId COMPONENT_A = 5;
+constexpr ComponentId COMPONENT_B = 6;
+
+void registerTestComponents() {
+    auto &mgr = GET_MODULE(ComponentInfoManager);
+    mgr.registerComponent(ComponentInfo{.id = ComponentIdByType<EntityId>::value, .size = sizeof(EntityId), .name = "eid"});
+    mgr.registerComponent(ComponentInfo{.id = COMPONENT_A, .size = 4, .name = "a"});
+    mgr.registerComponent(ComponentInfo{.id = COMPONENT_B, .size = 4, .name = "b"});
+}
+
+} // namespace
+
+TEST_CASE("forEachEnabledRun reports exactly the maximal runs of enabled rows", "[ecs]") {
+    registerTestComponents();
+    const size_t index_a = COMPONENT_A;
+    const size_t index_b = COMPONENT_B;
+
+    std::mt19937 rng{1234};
+    for (int iteration = 0; iteration < 500; iteration++) {
+        const size_t indices[] = {0, index_a, index_b};
+        const ComponentId ids[] = {0, COMPONENT_A, COMPONENT_B};
+        ECSComponentChunk chunk{indices, ids};
+
+        // sizes around word boundaries are the interesting ones
+        const size_t row_count = std::min<size_t>(chunk.capacity(), 1 + rng() % 300);
+        std::vector<void *> ptrs(3);
+        REQUIRE(chunk.allocate(indices, ptrs, row_count) == row_count);
+
+        std::vector<bool> enabled_a(row_count, true);
+        std::vector<bool> enabled_b(row_count, true);
+        const int toggle_count = rng() % 200;
+        for (int k = 0; k < toggle_count; k++) {
+            const size_t row = rng() % row_count;
+            const bool enabled = rng() % 3 == 0;
+            if (rng() % 2) {
+                chunk.setEnabled(index_a, row, enabled);
+                enabled_a[row] = enabled;
+            } else {
+                chunk.setEnabled(index_b, row, enabled);
+                enabled_b[row] = enabled;
+            }
+        }
+
+        for (const bool both : {false, true}) {
+            const size_t query_a[] = {index_a};
+            const size_t query_ab[] = {index_a, index_b};
+            const std::span<const size_t> query = both ? std::span<const size_t>{query_ab} : query_a;
+
+            std::vector<bool> expected(row_count);
+            for (size_t row = 0; row < row_count; row++)
+                expected[row] = enabled_a[row] && (!both || enabled_b[row]);
+
+            std::vector<bool> reported(row_count, false);
+            size_t previous_end = 0;
+            bool ordered = true;
+            bool maximal = true;
+            chunk.forEachEnabledRun(query, [&](size_t begin, size_t end) {
+                // runs are non-empty, ascending, and separated by at least one disabled row
+                if (begin >= end || begin < previous_end || (previous_end != 0 && begin == previous_end))
+                    ordered = false;
+                if ((begin > 0 && expected[begin - 1]) || (end < row_count && expected[end]))
+                    maximal = false;
+                for (size_t row = begin; row < end && row < row_count; row++)
+                    reported[row] = true;
+                previous_end = end;
+            });
+
+            REQUIRE(ordered);
+            REQUIRE(maximal);
+            REQUIRE(previous_end <= row_count);
+            REQUIRE(reported == expected);
+        }
+    }
+}
+
+} // namespace Pelican
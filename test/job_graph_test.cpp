@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_graph.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Pelican {
+
+TEST_CASE("a task graph runs every node once per run, after its predecessors", "[job_graph]") {
+    JobSystem::Get().init(4, 1);
+
+    // two workers feed a sync point, then a CALLER node, then a worker node which throws, then its successor
+    constexpr int RUN_COUNT = 500;
+    std::vector<std::atomic<int>> runs(5);
+    std::atomic<int> violations{0};
+    std::atomic<int> caller_elsewhere{0};
+    const auto caller_thread = std::this_thread::get_id();
+    const auto after = [&](size_t node, std::initializer_list<size_t> predecessors) {
+        const int run = runs[node].load();
+        for (const auto p : predecessors) {
+            if (runs[p].load() != run + 1)
+                violations.fetch_add(1);
+        }
+        runs[node].fetch_add(1);
+    };
+
+    TaskGraph graph;
+    const auto a = graph.addNode("a", [&] { after(0, {}); });
+    const auto b = graph.addNode("b", [&] { after(1, {}); });
+    const auto sync = graph.addSyncPoint("sync");
+    const auto c = graph.addNode(
+        "c",
+        [&] {
+            after(2, {0, 1});
+            if (std::this_thread::get_id() != caller_thread)
+                caller_elsewhere.fetch_add(1);
+        },
+        TaskGraph::CALLER);
+    // a failing node is logged and still releases its successors
+    const auto d = graph.addNode("d", [&] {
+        after(3, {2});
+        throw std::runtime_error("node failed");
+    });
+    const auto e = graph.addNode("e", [&] { after(4, {3}); });
+    graph.addEdge(a, sync);
+    graph.addEdge(b, sync);
+    graph.addEdge(sync, c);
+    graph.addEdge(c, d);
+    graph.addEdge(d, e);
+
+    for (int run = 0; run < RUN_COUNT; run++) {
+        graph.run();
+        REQUIRE_FALSE(graph.running());
+    }
+    for (const auto &count : runs)
+        REQUIRE(count.load() == RUN_COUNT);
+    REQUIRE(violations.load() == 0);
+    REQUIRE(caller_elsewhere.load() == 0);
+
+    REQUIRE_THROWS_AS(graph.launch(), std::runtime_error); // CALLER nodes need run()
+}
+
+TEST_CASE("a launched task graph completes its handle after the last node", "[job_graph]") {
+    JobSystem::Get().init(4, 1);
+
+    // binary tree: node i runs after node i / 2
+    constexpr int NODE_COUNT = 100;
+    constexpr int RUN_COUNT = 100;
+    std::vector<std::atomic<int>> runs(NODE_COUNT);
+    std::atomic<int> violations{0};
+    TaskGraph graph;
+    for (int i = 0; i < NODE_COUNT; i++) {
+        graph.addNode("n", [&, i] {
+            if (i > 0 && runs[i / 2].load() != runs[i].load() + 1)
+                violations.fetch_add(1);
+            runs[i].fetch_add(1);
+        });
+        if (i > 0)
+            graph.addEdge(i / 2, i);
+    }
+
+    int incomplete_runs = 0;
+    for (int run = 0; run < RUN_COUNT; run++) {
+        const auto handle = graph.launch();
+        JobSystem::Get().wait(handle);
+        for (const auto &count : runs) {
+            if (count.load() != run + 1) {
+                incomplete_runs++;
+                break;
+            }
+        }
+    }
+    REQUIRE(incomplete_runs == 0);
+    REQUIRE(violations.load() == 0);
+}
+
+TEST_CASE("a task graph with a cycle is rejected", "[job_graph]") {
+    JobSystem::Get().init(4, 1);
+
+    std::atomic<int> ran{0};
+    TaskGraph graph;
+    const auto a = graph.addNode("a", [&] { ran.fetch_add(1); });
+    const auto b = graph.addNode("b", [&] { ran.fetch_add(1); });
+    graph.addEdge(a, b);
+    graph.addEdge(b, a);
+    REQUIRE_THROWS_AS(graph.run(), std::runtime_error);
+    REQUIRE(ran.load() == 0);
+}
+
+} // namespace Pelican
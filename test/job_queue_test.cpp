@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_queue.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Pelican {
+
+namespace {
+
+// Every item must be taken exactly once, by whichever thread got it
+struct Item {
+    std::atomic<int> taken{0};
+};
+
+bool takenOnce(const std::vector<Item> &items) {
+    for (const auto &item : items) {
+        if (item.taken.load() != 1)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("work stealing deque hands out every item once under concurrent steals", "[job_queue]") {
+    constexpr int ITEM_COUNT = 200000;
+    constexpr int THIEF_COUNT = 3;
+
+    std::vector<Item> items(ITEM_COUNT);
+    // small ring, so the owner grows it while thieves are reading
+    WorkStealingDeque<Item> deque{8};
+    std::atomic<bool> owner_done{false};
+    std::atomic<int> stolen{0};
+
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < THIEF_COUNT; t++) {
+        thieves.emplace_back([&] {
+            while (!owner_done.load(std::memory_order_acquire) || !deque.empty()) {
+                if (Item *item = deque.steal()) {
+                    item->taken.fetch_add(1);
+                    stolen.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    // owner pushes in bursts and pops part of each burst, racing the thieves for the last items
+    int popped = 0;
+    for (int i = 0; i < ITEM_COUNT;) {
+        const int burst = 1 + i % 37;
+        for (int k = 0; k < burst && i < ITEM_COUNT; k++, i++)
+            deque.push(&items[i]);
+        for (int k = 0; k < burst / 2; k++) {
+            if (Item *item = deque.pop()) {
+                item->taken.fetch_add(1);
+                popped++;
+            }
+        }
+    }
+    while (Item *item = deque.pop()) {
+        item->taken.fetch_add(1);
+        popped++;
+    }
+    owner_done.store(true, std::memory_order_release);
+    for (auto &thief : thieves)
+        thief.join();
+
+    REQUIRE(popped + stolen.load() == ITEM_COUNT);
+    REQUIRE(takenOnce(items));
+    REQUIRE(deque.empty());
+}
+
+TEST_CASE("injection queue hands out every item once with several producers and consumers", "[job_queue]") {
+    constexpr int PRODUCER_COUNT = 4;
+    constexpr int CONSUMER_COUNT = 4;
+    constexpr int ITEMS_PER_PRODUCER = 50000;
+    constexpr int ITEM_COUNT = PRODUCER_COUNT * ITEMS_PER_PRODUCER;
+
+    std::vector<Item> items(ITEM_COUNT);
+    // smaller than the item count, so producers also hit a full queue
+    InjectionQueue<Item> queue{1024};
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < PRODUCER_COUNT; p++) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                while (!queue.push(&items[p * ITEMS_PER_PRODUCER + i]))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < CONSUMER_COUNT; c++) {
+        threads.emplace_back([&] {
+            while (consumed.load() < ITEM_COUNT) {
+                if (Item *item = queue.pop()) {
+                    item->taken.fetch_add(1);
+                    consumed.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    REQUIRE(consumed.load() == ITEM_COUNT);
+    REQUIRE(takenOnce(items));
+    REQUIRE(queue.empty());
+}
+
+} // namespace Pelican
@@ -0,0 +1,220 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_system.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace Pelican {
+
+TEST_CASE("jobs start only after every dependency has completed", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    constexpr int ROUND_COUNT = 2000;
+    std::atomic<int> violations{0};
+    for (int round = 0; round < ROUND_COUNT; round++) {
+        std::atomic<bool> a_done{false};
+        std::atomic<bool> b_done{false};
+        const auto a = JobSystem::Get().schedule([&] { a_done.store(true); });
+        const auto b = JobSystem::Get().schedule([&] { b_done.store(true); });
+        // some rounds depend on a job which has already completed
+        if (round % 3 == 0)
+            JobSystem::Get().wait(a);
+
+        const JobHandle dependencies[] = {a, b};
+        const auto c = JobSystem::Get().schedule(
+            [&] {
+                if (!a_done.load() || !b_done.load())
+                    violations.fetch_add(1);
+            },
+            dependencies);
+        JobSystem::Get().wait(c);
+        REQUIRE(c->done());
+    }
+    REQUIRE(violations.load() == 0);
+}
+
+TEST_CASE("dependents of a counter wait for jobs scheduled into it by running jobs", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    constexpr int ROUND_COUNT = 1000;
+    constexpr int CHILD_COUNT = 8;
+    std::atomic<int> violations{0};
+    for (int round = 0; round < ROUND_COUNT; round++) {
+        std::atomic<int> children_run{0};
+        const auto group = JobHandle::create();
+        JobSystem::Get().scheduleInto(group, [&, group] {
+            for (int i = 0; i < CHILD_COUNT; i++)
+                JobSystem::Get().scheduleInto(group, [&] { children_run.fetch_add(1); });
+        });
+
+        const JobHandle dependencies[] = {group};
+        const auto continuation = JobSystem::Get().schedule(
+            [&] {
+                if (children_run.load() != CHILD_COUNT)
+                    violations.fetch_add(1);
+            },
+            dependencies);
+        JobSystem::Get().wait(continuation);
+    }
+    REQUIRE(violations.load() == 0);
+}
+
+TEST_CASE("layers of jobs are released once the whole previous layer has finished", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    constexpr int LAYER_COUNT = 64;
+    constexpr int WIDTH = 16;
+    std::vector<std::atomic<int>> finished(LAYER_COUNT);
+    std::atomic<int> violations{0};
+
+    std::vector<JobHandle> previous;
+    for (int layer = 0; layer < LAYER_COUNT; layer++) {
+        std::vector<JobHandle> current;
+        for (int i = 0; i < WIDTH; i++) {
+            current.push_back(JobSystem::Get().schedule(
+                [&, layer] {
+                    if (layer > 0 && finished[layer - 1].load() != WIDTH)
+                        violations.fetch_add(1);
+                    finished[layer].fetch_add(1);
+                },
+                previous));
+        }
+        previous = std::move(current);
+    }
+    JobSystem::Get().wait();
+
+    REQUIRE(violations.load() == 0);
+    REQUIRE(finished[LAYER_COUNT - 1].load() == WIDTH);
+}
+
+TEST_CASE("threads waiting on a handle run the job its dependency releases", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+    const size_t io = JobSystem::Get().dedicatedThread("test_io");
+    // one waiter per worker, so every worker is parked in wait() when the dependency finishes
+    const int waiter_count = static_cast<int>(JobSystem::Get().workerCount());
+
+    constexpr int ROUND_COUNT = 5;
+    std::atomic<int> waiters_done{0};
+    for (int round = 0; round < ROUND_COUNT; round++) {
+        std::atomic<int> arrived{0};
+        // released into the worker queues by the dedicated thread, after the waiters had time to park
+        const auto io_job = JobSystem::Get().scheduleOn(io, [&] {
+            while (arrived.load() != waiter_count)
+                std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+        const JobHandle io_dependency[] = {io_job};
+        const auto inner = JobSystem::Get().schedule([] {}, io_dependency);
+
+        const auto outer = JobHandle::create();
+        for (int i = 0; i < waiter_count; i++) {
+            JobSystem::Get().scheduleInto(outer, [&, inner] {
+                // hold this worker until every worker has a waiter
+                arrived.fetch_add(1);
+                while (arrived.load() != waiter_count)
+                    std::this_thread::yield();
+                JobSystem::Get().wait(inner);
+                waiters_done.fetch_add(1);
+            });
+        }
+        while (arrived.load() != waiter_count)
+            std::this_thread::yield();
+        JobSystem::Get().wait(outer);
+    }
+    REQUIRE(waiters_done.load() == ROUND_COUNT * waiter_count);
+}
+
+TEST_CASE("parallelFor visits every index once", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    for (const size_t grain : {size_t{0}, size_t{1}, size_t{7}, size_t{5000}}) {
+        std::vector<std::atomic<int>> visits(20000);
+        JobSystem::Get().parallelFor(0, visits.size(), grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                visits[i].fetch_add(1);
+        });
+        bool once = true;
+        for (const auto &v : visits)
+            once = once && v.load() == 1;
+        REQUIRE(once);
+    }
+}
+
+TEST_CASE("parallelReduce folds the whole range", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    constexpr uint64_t N = 100000;
+    const uint64_t sum = JobSystem::Get().parallelReduce<uint64_t>(
+        0, N, 0, 0,
+        [](size_t begin, size_t end) {
+            uint64_t s = 0;
+            for (size_t i = begin; i < end; i++)
+                s += i;
+            return s;
+        },
+        std::plus<uint64_t>{});
+    REQUIRE(sum == N * (N - 1) / 2);
+    // an empty range gives the identity
+    const int empty = JobSystem::Get().parallelReduce<int>(5, 5, 0, 42, [](size_t, size_t) { return 1; }, std::plus<int>{});
+    REQUIRE(empty == 42);
+}
+
+TEST_CASE("parallel loops wait for every piece before rethrowing the first exception", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+
+    // the first piece runs on the caller right after the first forks went out, so it throws while they run
+    constexpr size_t N = 4096;
+    std::atomic<int> running{0};
+    const auto piece = [&](size_t begin, size_t end) {
+        running.fetch_add(1);
+        std::this_thread::yield();
+        running.fetch_sub(1);
+        if (begin == 0)
+            throw std::runtime_error("piece failed");
+        return static_cast<int>(end - begin);
+    };
+
+    int for_running = -1;
+    try {
+        JobSystem::Get().parallelFor(0, N, 16, piece);
+    } catch (const std::runtime_error &) {
+        for_running = running.load();
+    }
+    REQUIRE(for_running == 0);
+
+    int reduce_running = -1;
+    try {
+        JobSystem::Get().parallelReduce<int>(0, N, 16, 0, piece, std::plus<int>{});
+    } catch (const std::runtime_error &) {
+        reduce_running = running.load();
+    }
+    REQUIRE(reduce_running == 0);
+}
+
+TEST_CASE("a background job can schedule more background jobs than the queue holds", "[job_system]") {
+    JobSystem::Get().init(4, 1);
+    REQUIRE(JobSystem::Get().backgroundWorkerCount() == 1);
+
+    // the only background worker fills its own queue, so it has to drain it while pushing
+    constexpr int CHILD_COUNT = 20000;
+    std::atomic<int> children_run{0};
+    const auto group = JobHandle::create();
+    JobSystem::Get().scheduleInto(
+        group,
+        [&, group] {
+            for (int i = 0; i < CHILD_COUNT; i++) {
+                JobSystem::Get().scheduleInto(group, [&] { children_run.fetch_add(1); }, {}, JobSystem::ANY_WORKER,
+                                              JobPriority::Background);
+            }
+        },
+        {}, JobSystem::ANY_WORKER, JobPriority::Background);
+    JobSystem::Get().wait(group);
+    REQUIRE(children_run.load() == CHILD_COUNT);
+}
+
+} // namespace Pelican
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "job_task.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Pelican {
+
+namespace {
+
+Task<int> square(int x) { co_return x * x; }
+
+Task<int> sumOfSquares(int n) {
+    int sum = 0;
+    for (int i = 1; i <= n; i++)
+        sum += co_await square(i); // child tasks run inline
+    co_return sum;
+}
+
+Task<int> failAfterJob() {
+    co_await JobSystem::Get().schedule([] {});
+    throw std::runtime_error("task failed");
+}
+
+Task<int> catchChildFailure() {
+    try {
+        co_return co_await failAfterJob();
+    } catch (const std::runtime_error &) {
+        co_return -1;
+    }
+}
+
+// Runs frames on the main thread until every handle has completed
+void pumpMainThread(const std::vector<JobHandle> &handles) {
+    for (const auto &handle : handles) {
+        while (!handle->done()) {
+            JobSystem::Get().runMainThreadJobs();
+            std::this_thread::yield();
+        }
+    }
+}
+
+std::filesystem::path writeTempFile(const std::string &name, const std::string &contents) {
+    const auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream f{path, std::ios_base::binary | std::ios_base::trunc};
+    f << contents;
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("tasks return values and exceptions through co_await and get()", "[job_task]") {
+    JobSystem::Get().init(4, 1);
+
+    REQUIRE(sumOfSquares(10).get() == 385);
+    REQUIRE(catchChildFailure().get() == -1);
+    REQUIRE_THROWS_AS(failAfterJob().get(), std::runtime_error);
+
+    // the handle from start() completes only after the whole chain, awaited jobs included
+    std::atomic<int> finished{0};
+    // the coroutine refers to the lambda's captures, so the lambda has to outlive it
+    const auto make_chain = [&]() -> Task<void> {
+        for (int i = 0; i < 8; i++)
+            co_await JobSystem::Get().schedule([&] { finished.fetch_add(1); });
+    };
+    auto chain = make_chain();
+    JobSystem::Get().wait(chain.start());
+    REQUIRE(chain.done());
+    REQUIRE(finished.load() == 8);
+}
+
+TEST_CASE("switchToMain continues the task in runMainThreadJobs", "[job_task]") {
+    JobSystem::Get().init(4, 1);
+
+    constexpr int TASK_COUNT = 64;
+    std::atomic<int> on_main{0};
+    std::atomic<int> back_on_worker{0};
+    auto hop = [&]() -> Task<void> {
+        co_await switchToMain();
+        if (JobSystem::Get().isMainThread())
+            on_main.fetch_add(1);
+        co_await switchToWorker();
+        if (!JobSystem::Get().isMainThread())
+            back_on_worker.fetch_add(1);
+    };
+
+    std::vector<Task<void>> tasks;
+    std::vector<JobHandle> handles;
+    for (int i = 0; i < TASK_COUNT; i++) {
+        tasks.push_back(hop());
+        handles.push_back(tasks.back().start());
+    }
+    // nothing reaches the main thread part before the main thread runs its jobs
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(on_main.load() == 0);
+
+    pumpMainThread(handles);
+    REQUIRE(on_main.load() == TASK_COUNT);
+    REQUIRE(back_on_worker.load() == TASK_COUNT);
+}
+
+TEST_CASE("readFileAsync hands the file contents to the task", "[job_task]") {
+    JobSystem::Get().init(4, 1);
+
+    const std::string contents{"pelican\n\0binary", 15}; // binary data, not text
+    const auto path = writeTempFile("pelican_job_task_test.bin", contents);
+    auto read = [](std::string p) -> Task<std::string> {
+        const auto bytes = co_await readFileAsync(std::move(p));
+        co_return std::string(bytes.begin(), bytes.end());
+    };
+    REQUIRE(read(path.string()).get() == contents);
+
+    // many reads at once queue behind the background workers without blocking the caller's tasks
+    std::vector<Task<std::string>> tasks;
+    std::vector<JobHandle> handles;
+    for (int i = 0; i < 32; i++) {
+        tasks.push_back(read(path.string()));
+        handles.push_back(tasks.back().start());
+    }
+    pumpMainThread(handles);
+    for (auto &task : tasks)
+        REQUIRE(task.result() == contents);
+
+    std::filesystem::remove(path);
+    REQUIRE_THROWS_AS(read(path.string()).get(), std::runtime_error);
+}
+
+} // namespace Pelican